@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+#include "benchaccess.h"
+
+// extends every distinct prefix of length depth (the position list) by a single character
+template <bool degenerate>
+static void BM_AdvanceCharacter(benchmark::State& state) {
+    const int depth = state.range(0);
+    GeneratorConfig config;
+    OrthoFamily family;
+    SuffixTreeBenchmark::generateFamily(config, false, family);
+    std::unique_ptr<SuffixTree> tree(SuffixTreeBenchmark::build(family));
+    STPositionsPerLetter positions(depth + 2, depth + 1);
+    SuffixTreeBenchmark::matchAll(*tree, positions, depth);
+    const IupacMask& mask = IupacMask::characterToMask[degenerate ? 'R' : 'A'];
+    occurence_bits occurence;
+    for (auto _ : state) {
+        if (degenerate) {
+            SuffixTreeBenchmark::advanceIupacCharacter(*tree, mask, depth, positions, occurence);
+        } else {
+            SuffixTreeBenchmark::advanceExactCharacter(*tree, mask, depth, positions, occurence);
+        }
+        benchmark::DoNotOptimize(occurence);
+    }
+    state.SetItemsProcessed(state.iterations() * positions.list[depth].validPositions);
+    state.counters["positions"] = positions.list[depth].validPositions;
+}
+BENCHMARK_TEMPLATE(BM_AdvanceCharacter, false)->DenseRange(0, 6);
+BENCHMARK_TEMPLATE(BM_AdvanceCharacter, true)->DenseRange(0, 6);
+
+// iterates over all motifs of a family, with the nodes in construction order (-1) or laid out with the given breadth first levels
+static void BM_IterateMotifs(benchmark::State& state) {
+    const int levels = state.range(0);
+    GeneratorConfig config;
+    config.sequenceLength = state.range(1);
+    OrthoFamily family;
+    SuffixTreeBenchmark::generateFamily(config, false, family);
+    std::streambuf* log = std::cerr.rdbuf(NULL); // the constructor reports every tree
+    std::unique_ptr<SuffixTree> tree(SuffixTreeBenchmark::build(family, levels));
+    std::cerr.rdbuf(log);
+    std::cerr.clear();
+    std::ostream out(NULL);
+    int motifs = 0;
+    for (auto _ : state) {
+        motifs = tree->printMotifs(std::make_pair<short, short>(6, 10), TWOFOLDSANDN, 1, *family.bls, out, false);
+        benchmark::DoNotOptimize(motifs);
+    }
+    state.SetItemsProcessed(state.iterations() * tree->getMotifsIteratedCount());
+    state.counters["motifs"] = motifs;
+}
+BENCHMARK(BM_IterateMotifs)->ArgsProduct({{-1, 0, 2, 4, 8}, {500, 4000}})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
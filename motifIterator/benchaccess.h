@@ -0,0 +1,66 @@
+#ifndef BENCHACCESS_H
+#define BENCHACCESS_H
+
+#include <sstream>
+#include "benchgenerator.h"
+#include "genefamily.h"
+
+/**
+ * Access to the private kernels of the suffix tree for the microbenchmarks, with inputs from the synthetic generator
+ */
+struct SuffixTreeBenchmark {
+    static const std::vector<float>& blsThresholds() {
+        static const std::vector<float> thresholds = {0.15f, 0.5f, 0.6f, 0.7f, 0.9f, 0.95f};
+        return thresholds;
+    }
+
+    // a single generated family, as it is read by motifIterator
+    static void generateFamily(const GeneratorConfig& config, const bool aligned, OrthoFamily& family) {
+        GeneratorConfig single(config);
+        single.families = 1;
+        std::istringstream in(SyntheticGenerator(single).generate(aligned, false));
+        GeneFamily::readFamily(in, blsThresholds(), family);
+    }
+
+    static SuffixTree* build(const OrthoFamily& family) {
+        return new SuffixTree(family.T, family.name, true, family.stringStartPositions, family.gene_names, family.next_gene_locations,
+            family.order_of_species_mapping, NULL);
+    }
+
+    // threads > 1 builds the tree with SuffixTree::constructPartitioned
+    static SuffixTree* buildPartitioned(const OrthoFamily& family, const int threads) {
+        return new SuffixTree(family.T, family.name, true, family.stringStartPositions, family.gene_names, family.next_gene_locations,
+            family.order_of_species_mapping, NULL, threads);
+    }
+
+    // levels < 0 keeps the construction order
+    static SuffixTree* build(const OrthoFamily& family, const int relayoutLevels) {
+        SuffixTree* tree = build(family);
+        if (relayoutLevels >= 0)
+            tree->relayout(relayoutLevels);
+        return tree;
+    }
+
+    // positions.list[d] holds every node position of depth d <= depth, i.e. every distinct prefix (extended with 'N')
+    static void matchAll(const SuffixTree& tree, STPositionsPerLetter& positions, const int depth) {
+        occurence_bits occurence;
+        positions.list[0].addSTPosition(tree.root);
+        for (int d = 0; d < depth; d++) {
+            tree.advanceIupacCharacter(IupacMask::characterToMask['N'], d, positions, occurence);
+        }
+    }
+
+    static void advanceExactCharacter(const SuffixTree& tree, const IupacMask& mask, const int depth, STPositionsPerLetter& positions, occurence_bits& occurence) {
+        tree.advanceExactCharacter(mask, depth, positions, occurence);
+    }
+
+    static void advanceIupacCharacter(const SuffixTree& tree, const IupacMask& mask, const int depth, STPositionsPerLetter& positions, occurence_bits& occurence) {
+        tree.advanceIupacCharacter(mask, depth, positions, occurence);
+    }
+
+    static void getOccurrences(const SuffixTree& tree, const STPosition& pos, std::vector<size_t>& occ) {
+        tree.getOccurrences(pos, occ);
+    }
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include <sstream>
+#include <set>
+#include "benchgenerator.h"
+
+static const char bases[] = "ACGT";
+static const char iupac[] = "ACGTNRYSWKMBDHV";
+
+std::string SyntheticGenerator::randomSequence(const size_t length) {
+    std::string sequence(length, 'A');
+    for (char& c : sequence) {
+        c = bases[random(4)];
+    }
+    return sequence;
+}
+
+// joins two random subtrees until one is left, the root has no branch length
+std::string SyntheticGenerator::randomTree(std::vector<std::string> nodes) {
+    std::ostringstream branch;
+    for (std::string& node : nodes) {
+        branch.str("");
+        branch << ':' << 0.01 + 0.29 * probability();
+        node += branch.str();
+    }
+    while (nodes.size() > 1) {
+        size_t i = random(nodes.size());
+        std::string a = nodes[i];
+        nodes.erase(nodes.begin() + i);
+        i = random(nodes.size());
+        std::string b = nodes[i];
+        nodes.erase(nodes.begin() + i);
+        branch.str("");
+        branch << '(' << a << ',' << b << "):" << 0.01 + 0.29 * probability();
+        nodes.push_back(branch.str());
+    }
+    return nodes[0].substr(0, nodes[0].find_last_of(':')) + ";";
+}
+
+std::string SyntheticGenerator::randomGene(const std::vector<std::string>& repeats, const std::vector<std::string>& planted) {
+    std::string gene;
+    gene.reserve(config.sequenceLength);
+    while (gene.size() < (size_t)config.sequenceLength) {
+        if (!repeats.empty() && probability() < config.repeatFraction) {
+            gene += repeats[random(repeats.size())];
+        } else {
+            gene += randomSequence(std::min((size_t)50, config.sequenceLength - gene.size()));
+        }
+    }
+    gene.resize(config.sequenceLength);
+    for (const std::string& motif : planted) {
+        if (gene.size() > motif.size() && probability() < 0.8) {
+            gene.replace(random(gene.size() - motif.size()), motif.size(), motif);
+        }
+    }
+    return gene;
+}
+
+std::string SyntheticGenerator::mutate(const std::string& sequence) {
+    std::string mutated(sequence);
+    for (char& c : mutated) {
+        double p = probability();
+        if (p < config.mutationRate * 0.75) {
+            c = bases[random(4)];
+        } else if (p < config.mutationRate) {
+            c = '-';
+        }
+    }
+    return mutated;
+}
+
+// prefixes of the planted motifs, which are found, and random (degenerate) motifs that are mostly absent
+void SyntheticGenerator::writeQueries(std::ostream& out, const std::vector<std::string>& planted) {
+    std::set<std::string> motifs;
+    const size_t minLength = std::min(6, config.plantedLength);
+    for (const std::string& motif : planted) {
+        for (size_t k = minLength; k <= motif.size() && motifs.size() < (size_t)config.queries; k++) {
+            motifs.insert(motif.substr(0, k));
+        }
+    }
+    while (motifs.size() < (size_t)config.queries) {
+        motifs.insert(randomMotif(minLength + random(config.plantedLength - minLength + 1), 2));
+    }
+    for (const std::string& motif : motifs) {
+        out << motif << '\t' << random(3) << '\n';
+    }
+    out << '\n';
+}
+
+std::string SyntheticGenerator::randomMotif(const size_t length, const int maxDegenerate) {
+    std::string motif = randomSequence(length);
+    for (size_t d = random(maxDegenerate + 1); d > 0; d--) {
+        motif[random(motif.size())] = iupac[random(15)];
+    }
+    return motif;
+}
+
+std::string SyntheticGenerator::speciesTree() {
+    std::vector<std::string> species;
+    for (int s = 0; s < config.species; s++) {
+        species.push_back("SP" + std::to_string(s));
+    }
+    return randomTree(species);
+}
+
+void SyntheticGenerator::writeFamilies(std::ostream& out, const bool aligned, const bool withQueries) {
+    std::vector<std::string> species;
+    for (int s = 0; s < config.species; s++) {
+        species.push_back("SP" + std::to_string(s));
+    }
+    std::vector<std::string> repeats;
+    for (int r = 0; r < 8; r++) {
+        repeats.push_back(randomSequence(20 + random(40)));
+    }
+    for (int f = 0; f < config.families; f++) {
+        std::vector<std::string> planted;
+        for (int m = 0; m < config.plantedMotifs; m++) {
+            planted.push_back(randomSequence(config.plantedLength));
+        }
+        std::string alignment = aligned ? randomGene(repeats, planted) : "";
+        out << "FAM" << f << '\n' << (config.newick.empty() ? randomTree(species) : config.newick) << '\n' << config.species << '\n';
+        for (int s = 0; s < config.species; s++) {
+            int genes = aligned ? 1 : config.genesPerSpecies;
+            for (int g = 0; g < genes; g++) {
+                out << (g > 0 ? " " : "") << 'G' << f << '_' << s << '_' << g;
+            }
+            out << '\t' << species[s] << '\n';
+            for (int g = 0; g < genes; g++) {
+                out << (g > 0 ? " " : "") << (aligned ? mutate(alignment) : randomGene(repeats, planted));
+            }
+            out << '\n';
+        }
+        if (withQueries) {
+            writeQueries(out, planted);
+        }
+        out << '\n';
+    }
+}
+
+std::string SyntheticGenerator::generate(const bool aligned, const bool withQueries) {
+    std::ostringstream out;
+    writeFamilies(out, aligned, withQueries);
+    return out.str();
+}
@@ -0,0 +1,62 @@
+#ifndef BENCHGENERATOR_H
+#define BENCHGENERATOR_H
+
+#include <string>
+#include <vector>
+#include <random>
+#include <iostream>
+
+// parameters of the synthetic ortho groups, the same parameters (and seed) always give the same input
+struct GeneratorConfig {
+    int families = 4;
+    int species = 8;              // at most N_BITS
+    std::string newick;           // tree over the species SP0 .. SP<species - 1>, a random tree is used when empty
+    int genesPerSpecies = 2;      // alignment based families always have a single gene per species
+    int sequenceLength = 2000;    // length of a gene
+    double repeatFraction = 0.1;  // fraction of every gene copied from a small pool of repeat elements
+    int plantedMotifs = 16;       // conserved motifs per family, each one is planted in most of its genes
+    int plantedLength = 9;
+    double mutationRate = 0.1;    // substitutions and gaps per column of an alignment based family
+    int queries = 2000;           // motifs to locate per family (location mode input)
+    unsigned int seed = 1;
+};
+
+/**
+ * Writes synthetic ortho groups in the input format of motifIterator, so benchmarks run on repeatable inputs of any size.
+ * Alignment free families get unrelated genes that share the planted motifs, alignment based families are mutated copies of one sequence.
+ */
+class SyntheticGenerator {
+private:
+    GeneratorConfig config;
+    std::mt19937 rng;
+
+    size_t random(const size_t n) { return rng() % n; }
+    double probability() { return (rng() >> 8) / (double)(1 << 24); }
+    std::string randomSequence(const size_t length);
+    std::string randomTree(std::vector<std::string> nodes);
+    std::string randomGene(const std::vector<std::string>& repeats, const std::vector<std::string>& planted);
+    std::string mutate(const std::string& sequence);
+    void writeQueries(std::ostream& out, const std::vector<std::string>& planted);
+
+public:
+    SyntheticGenerator(const GeneratorConfig& config_) : config(config_), rng(config_.seed) {}
+
+    /**
+     * Writes all families
+     * @param aligned write alignment based families (one gene per species, columns are aligned)
+     * @param withQueries follow every family by a list of motifs to locate, as in location mode
+     */
+    void writeFamilies(std::ostream& out, const bool aligned, const bool withQueries);
+    std::string generate(const bool aligned, const bool withQueries);
+
+    /**
+     * Random newick tree over the species SP0 .. SP<species - 1>
+     */
+    std::string speciesTree();
+    /**
+     * Random motif with up to maxDegenerate degenerate IUPAC characters
+     */
+    std::string randomMotif(const size_t length, const int maxDegenerate);
+};
+
+#endif
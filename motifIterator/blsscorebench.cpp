@@ -0,0 +1,17 @@
+#include <benchmark/benchmark.h>
+#include "benchaccess.h"
+
+// BLSScore precomputes the score of every occurence, so its construction grows with 2^species
+static void BM_BLSScoreConstruction(benchmark::State& state) {
+    GeneratorConfig config;
+    config.species = state.range(0);
+    std::string newick = SyntheticGenerator(config).speciesTree();
+    for (auto _ : state) {
+        std::vector<std::string> order_of_species;
+        BLSScore bls(SuffixTreeBenchmark::blsThresholds(), newick, config.species, order_of_species);
+        benchmark::DoNotOptimize(&bls);
+    }
+}
+BENCHMARK(BM_BLSScoreConstruction)->DenseRange(4, 16, 2)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,56 @@
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include "checkpoint.h"
+
+static const char checkpointMagic[8] = {'M', 'I', 'C', 'K', 'P', 'T', '0', '1'};
+
+bool Checkpoint::write(const std::string& filename, const MyMotifMap* motifmap) const {
+    std::string tmpname = filename + ".tmp";
+    {
+        std::ofstream out(tmpname.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(checkpointMagic, sizeof(checkpointMagic));
+        out.write((const char*)&inputOffset, sizeof(inputOffset));
+        out.write((const char*)&outputOffset, sizeof(outputOffset));
+        out.write((const char*)&families, sizeof(families));
+        out.write((const char*)&motifCount, sizeof(motifCount));
+        out.put(motifmap != NULL);
+        if (motifmap != NULL)
+            motifmap->write(out);
+        out.flush();
+        if (!out) {
+            std::cerr << "could not write checkpoint " << tmpname << std::endl;
+            return false;
+        }
+    }
+    if (std::rename(tmpname.c_str(), filename.c_str()) != 0) {
+        std::cerr << "could not rename checkpoint " << tmpname << " to " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::read(const std::string& filename, MyMotifMap* motifmap) {
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    char magic[sizeof(checkpointMagic)];
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, checkpointMagic, sizeof(magic)) != 0) {
+        std::cerr << "no valid checkpoint in " << filename << std::endl;
+        return false;
+    }
+    in.read((char*)&inputOffset, sizeof(inputOffset));
+    in.read((char*)&outputOffset, sizeof(outputOffset));
+    in.read((char*)&families, sizeof(families));
+    in.read((char*)&motifCount, sizeof(motifCount));
+    bool hasMap = in.get() == 1;
+    if (hasMap != (motifmap != NULL)) {
+        std::cerr << "checkpoint " << filename << (hasMap ? " has" : " has no") << " motif map, resume with the same arguments" << std::endl;
+        return false;
+    }
+    if (motifmap != NULL)
+        motifmap->read(in);
+    if (!in) {
+        std::cerr << "checkpoint " << filename << " is truncated" << std::endl;
+        return false;
+    }
+    return true;
+}
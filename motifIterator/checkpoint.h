@@ -0,0 +1,30 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <cstdint>
+#include "suffixtree.h"
+
+/**
+ * State of a discovery run after a finished family, enough to continue the run with --resume.
+ * The motif map (countBls mode) is stored as a raw snapshot, so a checkpoint can only be resumed by the same build with the same arguments.
+ */
+struct Checkpoint {
+    uint64_t inputOffset = 0;   // input bytes consumed by the finished families
+    uint64_t outputOffset = 0;  // output bytes written for the finished families
+    uint64_t families = 0;
+    uint64_t motifCount = 0;    // valid motifs counted so far
+
+    /**
+     * Writes the checkpoint to a temporary file first and renames it, so a crash never leaves a broken checkpoint
+     * @param motifmap motif map to store, NULL if there is none
+     */
+    bool write(const std::string& filename, const MyMotifMap* motifmap) const;
+    /**
+     * @param motifmap motif map to restore, NULL if there is none
+     * @return false if the checkpoint could not be read
+     */
+    bool read(const std::string& filename, MyMotifMap* motifmap);
+};
+
+#endif
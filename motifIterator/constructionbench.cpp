@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+#include "benchaccess.h"
+
+// suffix tree construction (Ukkonen) for genes of increasing length, 8 species with 2 genes each
+static void BM_ConstructUkonen(benchmark::State& state) {
+    GeneratorConfig config;
+    config.sequenceLength = state.range(0);
+    OrthoFamily family;
+    SuffixTreeBenchmark::generateFamily(config, false, family);
+    std::streambuf* log = std::cerr.rdbuf(NULL); // the constructor reports every tree
+    for (auto _ : state) {
+        SuffixTree* tree = SuffixTreeBenchmark::build(family);
+        benchmark::DoNotOptimize(tree);
+        delete tree;
+    }
+    std::cerr.rdbuf(log);
+    std::cerr.clear();
+    state.SetBytesProcessed(state.iterations() * family.T.size());
+    state.counters["T"] = family.T.size();
+}
+BENCHMARK(BM_ConstructUkonen)->RangeMultiplier(4)->Range(500, 32000)->Unit(benchmark::kMillisecond);
+
+// the same families built with the suffixes partitioned by their first two characters, on 1 to 4 threads
+static void BM_ConstructPartitioned(benchmark::State& state) {
+    GeneratorConfig config;
+    config.sequenceLength = state.range(0);
+    OrthoFamily family;
+    SuffixTreeBenchmark::generateFamily(config, false, family);
+    std::streambuf* log = std::cerr.rdbuf(NULL);
+    for (auto _ : state) {
+        SuffixTree* tree = SuffixTreeBenchmark::buildPartitioned(family, state.range(1));
+        benchmark::DoNotOptimize(tree);
+        delete tree;
+    }
+    std::cerr.rdbuf(log);
+    std::cerr.clear();
+    state.SetBytesProcessed(state.iterations() * family.T.size());
+    state.counters["T"] = family.T.size();
+}
+BENCHMARK(BM_ConstructPartitioned)->ArgsProduct({{500, 8000, 32000}, {2, 4}})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
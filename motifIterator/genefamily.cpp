@@ -2,27 +2,24 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <unistd.h>
 #include "genefamily.h"
-
-std::chrono::time_point<std::chrono::system_clock> prevTime;
+#include "checkpoint.h"
+#include "treeindex.h"
+#include "spscqueue.h"
+#include "memorybudget.h"
+#include "kmertable.h"
 
 const std::unordered_set<char> GeneFamily::validCharacters ({ 'A', 'C', 'G', 'T', 'N', ' ', '$'  });
 
-void startChrono()
-{
-        prevTime = std::chrono::system_clock::now();
-}
-
-double stopChrono()
-{
-        std::chrono::duration<double> elapsed = std::chrono::system_clock::now() - prevTime;
-        return (elapsed.count());
-}
-
 void GeneFamily::readOrthologousFamily(const int mode, const std::string& filename, const std::vector<float> blsThresholds_, const Alphabet alphabet,
-const int type, const std::pair<short, short> l, const int maxDegeneration, const bool countBls, const float min_bls) {
+const int type, const std::pair<short, short> l, const int maxDegeneration, const bool countBls, const float min_bls, const RunOptions& options) {
     std::ifstream ifs(filename.c_str());
-    readOrthologousFamily(mode, ifs, blsThresholds_, alphabet, type, l, maxDegeneration, countBls);
+    readOrthologousFamily(mode, ifs, blsThresholds_, alphabet, type, l, maxDegeneration, countBls, min_bls, options);
 }
 
 size_t GeneFamily::getIndexOfVector(const std::vector<std::string> &v, const std::string &val) {
@@ -40,44 +37,45 @@ size_t GeneFamily::getIndexOfVector(const std::vector<std::string> &v, const std
 }
 
 
-void GeneFamily::readOrthologousFamily(const int mode, std::istream& ifs, const std::vector<float> blsThresholds_, const Alphabet alphabet,
-const int type, const std::pair<short, short> l, const int maxDegeneration, const bool countBls, const float min_bls) {
-  size_t totalCount = 0;
-  char blsvectorsize = (unsigned char)blsThresholds_.size(); // assume its less than 256
-  MyMotifMap motif_to_blsvector_map(blsvectorsize, l);
-  while (ifs) {
-    std::vector<size_t> stringStartPositions;
-    std::vector<size_t> next_gene_locations;
+bool GeneFamily::readFamily(std::istream& ifs, const std::vector<float>& blsThresholds_, OrthoFamily& family, const bool forwardStrandOnly) {
     std::vector<std::string> order_of_species;
-    std::vector<size_t> order_of_species_mapping;
-    std::vector<std::string> gene_names;
-    stringStartPositions.push_back(0);
+    family.stringStartPositions.clear();
+    family.next_gene_locations.clear();
+    family.order_of_species_mapping.clear();
+    family.gene_names.clear();
+    family.T.clear();
+    family.hasReverseComplement = !forwardStrandOnly;
+    family.stringStartPositions.push_back(0);
+    family.stats = FamilyStats();
+    Stopwatch parseTime;
     // READ DATA
-    std::string T, newick, line, name;
-    int N;
+    std::string newick, line;
     getline(ifs, line);
     while(ifs && line.empty()) {getline(ifs, line);}
-    if(!ifs || line.empty()) {continue;}
-    name = line;
+    if(!ifs || line.empty()) {return false;}
+    family.name = line;
     getline(ifs, newick);
     getline(ifs, line);
-    N = std::stoi(line);
-    BLSScore bls(blsThresholds_, newick, N, order_of_species);
-    // std::cerr << bls << std::endl;
+    family.N = std::stoi(line);
+    Stopwatch blsTime;
+    family.bls.reset(new BLSScore(blsThresholds_, newick, family.N, order_of_species));
+    family.stats.seconds[PHASE_BLS_PREP] = blsTime.seconds();
+    // std::cerr << *family.bls << std::endl;
     // int nr = 1;
     // for(auto x : order_of_species) {
     //     std::cerr << std::bitset<16>(nr) << "\t" << x << std::endl;
     //     nr = nr << 1;
     // }
+    std::string& T = family.T;
     size_t current_pos = 0;
-    next_gene_locations.push_back(current_pos);
-    for (int i = 0; i < N; i++) {
+    family.next_gene_locations.push_back(current_pos);
+    for (int i = 0; i < family.N; i++) {
         getline(ifs, line);
         // gene names
         std::vector<std::string> genes;
         std::string species = line.substr(line.find_first_of('\t')+1);
         // std::cerr << species << std::endl;
-        order_of_species_mapping.push_back(getIndexOfVector(order_of_species, species));
+        family.order_of_species_mapping.push_back(getIndexOfVector(order_of_species, species));
         line = line.substr(0, line.find_first_of('\t'));
         size_t start = 0;
         size_t end = line.find_first_of(' ', start);
@@ -88,14 +86,14 @@ const int type, const std::pair<short, short> l, const int maxDegeneration, cons
         }
         genes.push_back(line.substr(start));
         for (size_t k =0; k < genes.size(); k++) {
-            gene_names.push_back(genes[k]);
+            family.gene_names.push_back(genes[k]);
         } // add RC genes
-        for (size_t k = genes.size() ; k > 0; k--) {
-            gene_names.push_back(genes[k-1]);
+        for (size_t k = genes.size() ; k > 0 && !forwardStrandOnly; k--) {
+            family.gene_names.push_back(genes[k-1]);
         }
         // genes
         getline(ifs, line);
-        if (!T.empty())
+        if (!T.empty() && !forwardStrandOnly)
             T.push_back(IupacMask::DELIMITER);
         std::for_each(line.begin(), line.end(), [](char & c) { // convert all to upper case!
             if(c == IupacMask::FILLER)
@@ -110,9 +108,11 @@ const int type, const std::pair<short, short> l, const int maxDegeneration, cons
         });
         T.append(line);
         T.push_back(IupacMask::DELIMITER);
-        stringStartPositions.push_back(T.size());
-        T.append(Motif::ReverseComplement(line));
-        stringStartPositions.push_back(T.size() + 1);
+        family.stringStartPositions.push_back(T.size());
+        if (!forwardStrandOnly) {
+            T.append(Motif::ReverseComplement(line));
+            family.stringStartPositions.push_back(T.size() + 1);
+        }
         // std::cout << T << std::endl;
 
         // add gene start locations...
@@ -127,62 +127,438 @@ const int type, const std::pair<short, short> l, const int maxDegeneration, cons
         gene_sizes.push_back(line.size() + 1 - start);
         for (size_t k =0; k < gene_sizes.size(); k++) {
             current_pos += gene_sizes[k];
-            next_gene_locations.push_back(current_pos);
+            family.next_gene_locations.push_back(current_pos);
         } // add RC genes
-        for (size_t k = gene_sizes.size(); k > 0; k--) {
+        for (size_t k = gene_sizes.size(); k > 0 && !forwardStrandOnly; k--) {
             current_pos += gene_sizes[k - 1];
-            next_gene_locations.push_back(current_pos);
+            family.next_gene_locations.push_back(current_pos);
         }
     }
+    // the last string ends with the only two delimiters in a row, so each of its suffixes is unique and gets a leaf in the implicit suffix tree
+    if (!forwardStrandOnly) // the last reverse complement is not followed by a delimiter yet
+        T.push_back(IupacMask::DELIMITER);
     T.push_back(IupacMask::DELIMITER);
+    family.stringStartPositions.back() = T.size();
+    family.stats.name = family.name;
+    family.stats.species = family.N;
+    family.stats.textLength = T.size();
+    family.stats.seconds[PHASE_PARSE] = parseTime.seconds() - family.stats.seconds[PHASE_BLS_PREP];
+
+    std::cerr << "[" << family.name << "] " << family.N << " gene families " << std::endl;
+    return true;
+}
+
+// runs task(0) ... task(count - 1) on at most 'threads' threads, tasks are handed out in order
+static void runTasks(const size_t count, const int threads, const std::function<void(size_t)>& task) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            task(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < std::min((size_t)threads, count); t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+/**
+Location mode reads as many families (and their motif lists) as there are threads, builds their suffix trees in parallel
+and then splits every sorted motif list in blocks that are matched by the worker threads against the shared, read-only, tree.
+Each block writes to its own buffer and the buffers are written in order, so the output is identical for any number of threads.
+*/
+void GeneFamily::locateMotifs(std::istream& ifs, const std::vector<float> blsThresholds_, const std::pair<short, short> l,
+const int maxDegeneration, const float min_bls, const RunOptions& options, RunStats& stats, ProgressReporter& progress, std::ostream& out) {
+    const size_t minBlockSize = 1024; // smaller blocks lose too many shared prefixes
+    const size_t maxBlocksPerFamily = 4 * options.threads;
+    std::cerr << "min bls is " << min_bls << std::endl;
+    std::unique_ptr<TreeIndex> index;
+    if (!options.indexFile.empty()) {
+        index.reset(new TreeIndex(options.indexFile));
+        std::cerr << "tree index " << options.indexFile << " has " << index->familyCount() << " families" << std::endl;
+    }
+    std::ofstream saveIndex;
+    if (!options.saveIndexFile.empty()) {
+        saveIndex.open(options.saveIndexFile.c_str(), std::ios::binary | std::ios::trunc);
+        TreeIndex::writeHeader(saveIndex);
+    }
+    // a family that does not fit in the memory limit waits for the next batch
+    MemoryBudget budget(options.memoryLimit);
+    OrthoFamily pendingFamily;
+    std::vector<MotifQuery> pendingQueries;
+    bool pending = false;
+    bool moreFamilies = true;
+    while (moreFamilies || pending) {
+        std::vector<OrthoFamily> families;
+        std::vector<std::vector<MotifQuery>> queries;
+        size_t batchMemory = 0;
+        while (families.size() < (size_t)options.threads) {
+            OrthoFamily family;
+            std::vector<MotifQuery> familyQueries;
+            if (pending) {
+                family = std::move(pendingFamily);
+                familyQueries = std::move(pendingQueries);
+                pending = false;
+            } else {
+                if (!moreFamilies || !readFamily(ifs, blsThresholds_, family)) {
+                    moreFamilies = false;
+                    break;
+                }
+                MotifTrie::readQueries(ifs, familyQueries);
+                MotifTrie::sortQueries(familyQueries);
+            }
+            size_t memory = MemoryBudget::estimateFamily(family.T.size(), l.second, maxDegeneration);
+            if (!budget.tryAcquire(memory)) {
+                pendingFamily = std::move(family);
+                pendingQueries = std::move(familyQueries);
+                pending = true;
+                break;
+            }
+            batchMemory += memory;
+            queries.push_back(std::move(familyQueries));
+            families.push_back(std::move(family));
+        }
+        if (families.empty())
+            break;
+
+        // PROCESS DATA
+        std::vector<std::unique_ptr<SuffixTree>> trees(families.size());
+        runTasks(families.size(), options.threads, [&](size_t f) {
+            OrthoFamily& family = families[f];
+            Stopwatch buildTime;
+            if (index && index->isOpen())
+                trees[f].reset(index->map(family.name, family.T, family.order_of_species_mapping, family.gene_names)); // NULL if the family is not in the index
+            if (!trees[f]) {
+                trees[f].reset(new SuffixTree(family.T, family.name, true, family.stringStartPositions, family.gene_names, family.next_gene_locations, family.order_of_species_mapping, NULL, options.constructionThreads));
+                if (options.relayoutLevels >= 0)
+                    trees[f]->relayout(options.relayoutLevels);
+            }
+            family.stats.seconds[PHASE_TREE_BUILD] = buildTime.seconds();
+        });
+        if (saveIndex.is_open()) {
+            for (auto& tree : trees)
+                TreeIndex::write(saveIndex, *tree);
+        }
+
+        // <family, [first query, last query[>
+        std::vector<std::pair<size_t, std::pair<size_t, size_t>>> blocks;
+        for (size_t f = 0; f < families.size(); f++) {
+            size_t blockCount = std::max((size_t)1, std::min(maxBlocksPerFamily, (queries[f].size() + minBlockSize - 1) / minBlockSize));
+            size_t blockSize = std::max((size_t)1, (queries[f].size() + blockCount - 1) / blockCount);
+            size_t first = 0;
+            do {
+                blocks.push_back({f, {first, std::min(first + blockSize, queries[f].size())}});
+                first += blockSize;
+            } while (first < queries[f].size());
+        }
+        std::vector<std::string> output(blocks.size());
+        std::vector<double> blockSeconds(blocks.size());
+        runTasks(blocks.size(), options.threads, [&](size_t b) {
+            size_t f = blocks[b].first;
+            Stopwatch matchTime;
+            MotifTrie trie(queries[f].begin() + blocks[b].second.first, queries[f].begin() + blocks[b].second.second);
+            std::ostringstream blockOut;
+            trees[f]->matchMotifTrie(trie, blockOut, *families[f].bls, maxDegeneration, min_bls, options.binaryPositions);
+            output[b] = blockOut.str();
+            blockSeconds[b] = matchTime.seconds();
+        });
+
+        size_t b = 0;
+        for (size_t f = 0; f < families.size(); f++) {
+            FamilyStats& familyStats = families[f].stats;
+            Stopwatch outputTime;
+            size_t bytes = 0;
+            if (options.binaryPositions) trees[f]->writeGeneTable(out);
+            for (; b < blocks.size() && blocks[b].first == f; b++) {
+                out << output[b];
+                bytes += output[b].size();
+                familyStats.seconds[PHASE_ITERATION] += blockSeconds[b];
+            }
+            if (options.binaryPositions) out.put(0); // motif of length 0 ends the family
+            familyStats.seconds[PHASE_OUTPUT] = outputTime.seconds();
+            familyStats.counters[COUNTER_MOTIFS_EMITTED] = queries[f].size();
+            familyStats.counters[COUNTER_BYTES_WRITTEN] = bytes;
+            familyStats.counters[COUNTER_TREE_NODES] = trees[f]->getNodeCount();
+            stats.addFamily(familyStats);
+            progress.familyDone(queries[f].size());
+            // the blocks of a family run interleaved with those of the other families, so its own time is the sum of its blocks
+            std::cerr << "[" << families[f].name << "] " << queries[f].size() <<  " motifs located in " << familyStats.seconds[PHASE_ITERATION] << "s" << std::endl;
+        }
+        trees.clear();
+        budget.release(batchMemory);
+    }
+    if (saveIndex.is_open() && !saveIndex.flush())
+        std::cerr << "could not write tree index " << options.saveIndexFile << std::endl;
+}
+
+// opens the --output file, a resumed run continues after the output of the checkpoint
+static bool openOutput(const RunOptions& options, const Checkpoint* resumed, std::ofstream& outputFile) {
+  if (options.outputFile.empty()) {
+    if (resumed != NULL && resumed->outputOffset > 0)
+      std::cerr << "resuming without --output, the output continues after byte " << resumed->outputOffset << " of the previous output" << std::endl;
+    return true;
+  }
+  if (resumed != NULL && truncate(options.outputFile.c_str(), resumed->outputOffset) != 0) {
+    std::cerr << "cannot truncate " << options.outputFile << " to the checkpoint" << std::endl;
+    return false;
+  }
+  outputFile.open(options.outputFile.c_str(), std::ios::binary | (resumed != NULL ? std::ios::app : std::ios::trunc));
+  if (!outputFile) {
+    std::cerr << "cannot open output file " << options.outputFile << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// one family on its way through the discovery pipeline
+struct FamilyWork {
+  OrthoFamily family;
+  size_t inputEnd = 0;                // input consumed up to the end of this family, for the progress and checkpoints
+  size_t memory = 0;                  // estimate that is admitted by the MemoryBudget
+  std::unique_ptr<SuffixTree> tree;
+  std::string output;                 // output of an iterate thread
+  int count = 0;
+};
+typedef std::unique_ptr<FamilyWork> FamilyWorkPtr; // NULL ends the stream of a queue
+
+void GeneFamily::readOrthologousFamily(const int mode, std::istream& ifs, const std::vector<float> blsThresholds_, const Alphabet alphabet,
+const int type, const std::pair<short, short> l, const int maxDegeneration, const bool countBls, const float min_bls, const RunOptions& options) {
+  RunStats stats(options.statsFile);
+  // all input is read through a counting buffer so the progress is known for files and stdin alike
+  CountingInputBuffer inBuffer(ifs.rdbuf());
+  std::istream in(&inBuffer);
+  ProgressReporter progress(options.progressInterval, inBuffer, ProgressReporter::remainingBytes(ifs));
+  std::ofstream outputFile;
+  if (mode == 1) {
+    if (!options.checkpointFile.empty())
+      std::cerr << "checkpoints are only written in discovery mode" << std::endl;
+    if (options.forwardStrandOnly)
+      std::cerr << "the forward strand index is only used in alignment free discovery" << std::endl;
+    if (options.kmerTable)
+      std::cerr << "the k-mer table is only used in alignment free discovery" << std::endl;
+    if (!openOutput(options, NULL, outputFile))
+      return;
+    locateMotifs(in, blsThresholds_, l, maxDegeneration, min_bls, options, stats, progress, outputFile.is_open() ? outputFile : std::cout);
+    stats.writeSummary();
+    return;
+  } else if (mode != 0) {
+    std::cerr << "wrong mode given: " << mode << std::endl;
+    return;
+  }
+  if (options.forwardStrandOnly && type != 1)
+    std::cerr << "the forward strand index is only used in alignment free discovery" << std::endl;
+  const bool forwardStrandOnly = options.forwardStrandOnly && type == 1;
+  if (options.kmerTable && (type != 1 || l.second - 1 > KmerTable::MAX_LENGTH))
+    std::cerr << "the k-mer table is only used in alignment free discovery of motifs up to length " << KmerTable::MAX_LENGTH << ", building suffix trees" << std::endl;
+  const bool kmerTable = options.kmerTable && type == 1 && l.second - 1 <= KmerTable::MAX_LENGTH;
+  size_t totalCount = 0;
+  char blsvectorsize = (unsigned char)blsThresholds_.size(); // assume its less than 256
+  MyMotifMap motif_to_blsvector_map(blsvectorsize, l);
 
-    std::cerr << "[" << name << "] " << N << " gene families " << std::endl;
-    // PROCESS DATA
-    startChrono();
-    // std::cerr << T << std::flush;
-    // for (auto x : order_of_species_mapping)
-        // std::cerr << x << std::endl;
-    // TODO create a unsorted map here with long (motif) ->  blsvector
-    // TOOD use the sparsemap from tsl , and after outout -> long byte (size of blsvec) then x unsigned char
-    SuffixTree ST(T, name, true, stringStartPositions, gene_names, next_gene_locations, order_of_species_mapping, countBls ? &motif_to_blsvector_map : NULL);
-
-    if (mode == 1) {
-        int count = ST.matchIupacPatterns(ifs, std::cout, bls, maxDegeneration, l.second, min_bls);
-        double elapsed = stopChrono();
-        std::cerr << "[" << name << "] " << count <<  " motifs located in " << elapsed << "s" << std::endl;
-    } else if (mode == 0) {
-        int count = ST.printMotifs(l, alphabet, maxDegeneration, bls, std::cout, type == 0); // 0 == AB, 1 is AF
-        size_t iteratorcount = ST.getMotifsIteratedCount();
-
-        totalCount += count;
-        double elapsed = stopChrono();
-        std::cerr << "[" << name << "] iterated over " << iteratorcount << " motifs" << std::endl;
-        // std::cerr << "\33[2K\r[" << name << "] iterated over " << iteratorcount << " motifs" << std::endl; // clear beginning if progress is kept!
-        std::cerr << "[" << name << "] counted " << count << " valid motifs in " << elapsed << "s" << std::endl;
+  Checkpoint checkpoint;
+  bool resumed = false;
+  if (options.resume) {
+    std::ifstream exists(options.checkpointFile.c_str());
+    if (!exists) {
+      std::cerr << "no checkpoint " << options.checkpointFile << " found, starting from the first family" << std::endl;
+    } else if (checkpoint.read(options.checkpointFile, countBls ? &motif_to_blsvector_map : NULL)) {
+      resumed = true;
     } else {
-        std::cerr << "wrong mode given: " << mode << std::endl;
+      return;
     }
   }
-  if (mode == 0) {
-    // emit motifs from motif_to_blsvector_map
-    long unique_count = 0;
-    startChrono();
-
-    // for (std::pair<long, blscounttype *> ele: motif_to_blsvector_map) {
-    //     // Do stuff
-    //     Motif::writeGroupIDAndMotifInBinary(ele.first, l.second, std::cout);
-    //     std::cout.write(&blsvectorsize, 1); // assume
-    //     for(size_t i = 0; i < blsThresholds_.size(); i++) {
-    //         std::cout.write((char*)&ele.second[i], sizeof(blscounttype));
-    //     }
-    //     delete ele.second;
-    //     unique_count++;
-    // }
-    motif_to_blsvector_map.recPrintAndDelete( unique_count, std::cout);
+  if (!openOutput(options, resumed ? &checkpoint : NULL, outputFile))
+    return;
+  if (resumed) {
+    // the families before the checkpoint are skipped, this also works for stdin
+    in.ignore(checkpoint.inputOffset);
+    totalCount = checkpoint.motifCount;
+    std::cerr << "resuming after " << checkpoint.families << " families" << std::endl;
+  }
+  const size_t outputStart = checkpoint.outputOffset; // 0 unless resumed
+  CountingStreamBuffer outBuffer(outputFile.is_open() ? outputFile.rdbuf() : std::cout.rdbuf());
+  std::ostream out(&outBuffer);
+  Stopwatch sinceCheckpoint;
+
+  /*
+  Discovery runs as a pipeline: a reader thread parses the families, buildThreads build their suffix trees and
+  iterateThreads iterate over their motifs into a buffer per family, this thread writes the buffers in input order.
+  Family s is built by builder s % B and iterated by iterator s % I, so every queue connects one producer with
+  one consumer and is filled in input order. The shared motif map of countBls is only filled by this thread.
+  */
+  const size_t B = options.buildThreads;
+  const size_t I = countBls ? 0 : options.iterateThreads; // 0: this thread iterates
+  const size_t lanes = std::max(I, (size_t)1);
+  const size_t queueDepth = 2; // families waiting per queue, bounds the memory that is read ahead
+  std::vector<std::unique_ptr<SPSCQueue<FamilyWorkPtr>>> readQueues, builtQueues, iteratedQueues;
+  for (size_t b = 0; b < B; b++)
+    readQueues.emplace_back(new SPSCQueue<FamilyWorkPtr>(queueDepth));
+  for (size_t q = 0; q < B * lanes; q++) // builder b to iterator i is queue b * lanes + i
+    builtQueues.emplace_back(new SPSCQueue<FamilyWorkPtr>(queueDepth));
+  for (size_t i = 0; i < I; i++)
+    iteratedQueues.emplace_back(new SPSCQueue<FamilyWorkPtr>(queueDepth));
+
+  // the reader waits while the families in flight would exceed the memory limit, they are released after their output
+  MemoryBudget budget(options.memoryLimit);
+  // with the k-mer table every lane fills its own table for each family instead of a builder building a tree
+  std::vector<std::unique_ptr<KmerTable>> tables;
+  for (size_t i = 0; kmerTable && i < lanes; i++)
+    tables.emplace_back(new KmerTable(l.second - 1));
+  if (kmerTable) { // the tables are kept for the whole run
+    const size_t tableMemory = lanes * MemoryBudget::estimateKmerTable(l.second - 1);
+    if (budget.isLimited() && tableMemory > options.memoryLimit)
+      std::cerr << "the k-mer tables need about " << tableMemory / (1024.0 * 1024) << "MB, more than the memory limit, the families run alone" << std::endl;
+    budget.reserve(tableMemory);
+  }
+  auto iterateTable = [&](FamilyWork& work, KmerTable& table, std::ostream& familyOut) {
+    OrthoFamily& family = work.family;
+    FamilyStats& familyStats = family.stats;
+    Stopwatch buildTime;
+    table.build(family.T, family.hasReverseComplement, family.stringStartPositions, family.order_of_species_mapping);
+    familyStats.seconds[PHASE_TREE_BUILD] = buildTime.seconds();
+    Stopwatch iterationTime;
+    work.count = table.printMotifs(l, alphabet, maxDegeneration, *family.bls, countBls ? &motif_to_blsvector_map : NULL, familyOut);
+    familyStats.seconds[PHASE_ITERATION] = iterationTime.seconds();
+    familyStats.counters[COUNTER_NODES_VISITED] = table.getNodesVisitedCount();
+    familyStats.counters[COUNTER_POSITIONS_ADVANCED] = table.getPositionsAdvancedCount();
+    familyStats.counters[COUNTER_MOTIFS_ITERATED] = table.getMotifsIteratedCount();
+    familyStats.counters[COUNTER_MOTIFS_EMITTED] = work.count;
+  };
+  auto iterate = [&](FamilyWork& work, const size_t lane, std::ostream& familyOut) {
+    if (kmerTable) {
+      iterateTable(work, *tables[lane], familyOut);
+      return;
+    }
+    FamilyStats& familyStats = work.family.stats;
+    Stopwatch iterationTime;
+    work.count = work.tree->printMotifs(l, alphabet, maxDegeneration, *work.family.bls, familyOut, type == 0); // 0 == AB, 1 is AF
+    familyStats.seconds[PHASE_ITERATION] = iterationTime.seconds();
+    familyStats.counters[COUNTER_NODES_VISITED] = work.tree->getNodesVisitedCount();
+    familyStats.counters[COUNTER_POSITIONS_ADVANCED] = work.tree->getPositionsAdvancedCount();
+    familyStats.counters[COUNTER_MOTIFS_ITERATED] = work.tree->getMotifsIteratedCount();
+    familyStats.counters[COUNTER_MOTIFS_EMITTED] = work.count;
+    familyStats.counters[COUNTER_TREE_NODES] = work.tree->getNodeCount();
+    work.tree.reset(); // the tree is not needed for the output
+  };
+
+  std::vector<std::thread> stages;
+  stages.emplace_back([&]() {
+    for (size_t s = 0; ; s++) {
+      FamilyWorkPtr work(new FamilyWork());
+      if (!readFamily(in, blsThresholds_, work->family, forwardStrandOnly))
+        break;
+      work->inputEnd = inBuffer.consumed();
+      work->memory = MemoryBudget::estimateFamily(work->family.T.size(), l.second, maxDegeneration);
+      if (budget.isLimited() && work->memory > options.memoryLimit)
+        std::cerr << "[" << work->family.name << "] needs about " << work->memory / (1024.0 * 1024) << "MB, more than the memory limit, it runs alone" << std::endl;
+      budget.acquire(work->memory);
+      readQueues[s % B]->push(std::move(work));
+    }
+    for (auto& queue : readQueues)
+      queue->push(NULL);
+  });
+  for (size_t b = 0; b < B; b++) {
+    stages.emplace_back([&, b]() {
+      for (size_t s = b; ; s += B) {
+        FamilyWorkPtr work = readQueues[b]->pop();
+        if (!work)
+          break;
+        OrthoFamily& family = work->family;
+        if (kmerTable) { // the table is filled by the iterate lane
+          builtQueues[b * lanes + s % lanes]->push(std::move(work));
+          continue;
+        }
+        Stopwatch buildTime;
+        work->tree.reset(new SuffixTree(family.T, family.name, family.hasReverseComplement, family.stringStartPositions, family.gene_names, family.next_gene_locations, family.order_of_species_mapping, countBls ? &motif_to_blsvector_map : NULL, options.constructionThreads));
+        if (options.relayoutLevels >= 0)
+          work->tree->relayout(options.relayoutLevels);
+        family.stats.seconds[PHASE_TREE_BUILD] = buildTime.seconds();
+        builtQueues[b * lanes + s % lanes]->push(std::move(work));
+      }
+      for (size_t i = 0; i < lanes; i++)
+        builtQueues[b * lanes + i]->push(NULL);
+    });
+  }
+  for (size_t i = 0; i < I; i++) {
+    stages.emplace_back([&, i]() {
+      for (size_t s = i; ; s += I) {
+        FamilyWorkPtr work = builtQueues[(s % B) * lanes + i]->pop();
+        if (!work)
+          break;
+        std::ostringstream familyOut;
+        iterate(*work, i, familyOut);
+        work->output = familyOut.str();
+        iteratedQueues[i]->push(std::move(work));
+      }
+      iteratedQueues[i]->push(NULL);
+    });
+  }
+
+  for (size_t s = 0; ; s++) {
+    FamilyWorkPtr work = I > 0 ? iteratedQueues[s % I]->pop() : builtQueues[(s % B) * lanes]->pop();
+    if (!work)
+      break;
+    OrthoFamily& family = work->family;
+    FamilyStats& familyStats = family.stats;
+    size_t bytes = outBuffer.bytes();
+    if (I == 0)
+      iterate(*work, 0, out);
+    Stopwatch outputTime;
+    out << work->output;
+    out.flush();
+    familyStats.seconds[PHASE_OUTPUT] = outputTime.seconds();
+    familyStats.counters[COUNTER_BYTES_WRITTEN] = outBuffer.bytes() - bytes;
+    stats.addFamily(familyStats);
+    progress.familyDone(work->count, work->inputEnd);
+    budget.release(work->memory);
 
-    double elapsed = stopChrono();
-    std::cerr << "total motifs counted: " << totalCount ;
-    if(countBls) { std::cerr << " of which " << unique_count << " are unique [in " << elapsed << "s]"; }
-    std::cerr << std::endl;
+    totalCount += work->count;
+    double elapsed = familyStats.seconds[PHASE_TREE_BUILD] + familyStats.seconds[PHASE_ITERATION];
+    std::cerr << "[" << family.name << "] iterated over " << familyStats.counters[COUNTER_MOTIFS_ITERATED] << " motifs" << std::endl;
+    // std::cerr << "\33[2K\r[" << family.name << "] iterated over " << iteratorcount << " motifs" << std::endl; // clear beginning if progress is kept!
+    std::cerr << "[" << family.name << "] counted " << work->count << " valid motifs in " << elapsed << "s" << std::endl;
+
+    checkpoint.families++;
+    if (!options.checkpointFile.empty() && sinceCheckpoint.seconds() >= options.checkpointInterval) {
+      // the output of this family is already flushed
+      checkpoint.inputOffset = work->inputEnd;
+      checkpoint.outputOffset = outputStart + outBuffer.bytes();
+      checkpoint.motifCount = totalCount;
+      checkpoint.write(options.checkpointFile, countBls ? &motif_to_blsvector_map : NULL);
+      sinceCheckpoint.restart();
+    }
   }
+  for (auto& stage : stages)
+    stage.join();
+  // emit motifs from motif_to_blsvector_map
+  long unique_count = 0;
+  Stopwatch drainTime;
+  size_t bytes = outBuffer.bytes();
+
+  // for (std::pair<long, blscounttype *> ele: motif_to_blsvector_map) {
+  //     // Do stuff
+  //     Motif::writeGroupIDAndMotifInBinary(ele.first, l.second, std::cout);
+  //     std::cout.write(&blsvectorsize, 1); // assume
+  //     for(size_t i = 0; i < blsThresholds_.size(); i++) {
+  //         std::cout.write((char*)&ele.second[i], sizeof(blscounttype));
+  //     }
+  //     delete ele.second;
+  //     unique_count++;
+  // }
+  motif_to_blsvector_map.recPrintAndDelete( unique_count, out);
+  out.flush();
+
+  double elapsed = drainTime.seconds();
+  stats.addRunTime(PHASE_MAP_DRAIN, elapsed);
+  stats.addRunCounter(COUNTER_BYTES_WRITTEN, outBuffer.bytes() - bytes);
+  std::cerr << "total motifs counted: " << totalCount ;
+  if(countBls) { std::cerr << " of which " << unique_count << " are unique [in " << elapsed << "s]"; }
+  std::cerr << std::endl;
+  stats.writeSummary();
+  if (!options.checkpointFile.empty())
+    std::remove(options.checkpointFile.c_str()); // the run is complete, a later --resume starts over
 }
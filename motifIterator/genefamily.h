@@ -6,22 +6,72 @@
 #include <fstream>
 #include <chrono>
 #include <ctime>
+#include <memory>
 #include "suffixtree.h"
+#include "stats.h"
+#include "progress.h"
 
 
 #define MAX_VALID_CHARS 5
+
+// options that are given with --name value on the command line
+struct RunOptions {
+    int threads = 1;            // worker threads for motif location
+    int buildThreads = 1;       // discovery threads that build suffix trees
+    int iterateThreads = 1;     // discovery threads that iterate over the motifs, countBls always iterates on the output thread
+    bool binaryPositions = false; // write located motifs in the compact binary format (see SuffixTree::getLeafPositionsAndPrint)
+    std::string statsFile;      // json lines with the time per phase and the counters of every family, see RunStats
+    int progressInterval = 0;   // seconds between progress reports on stderr, 0 for none
+    std::string outputFile;     // write the output here instead of stdout, needed to resume a run
+    std::string checkpointFile; // discovery mode writes a checkpoint after a family, see Checkpoint
+    int checkpointInterval = 600; // minimum seconds between checkpoints
+    bool resume = false;        // continue from the checkpoint
+    std::string indexFile;      // location mode maps the suffix trees from this TreeIndex instead of building them
+    std::string saveIndexFile;  // location mode writes the suffix trees to a new TreeIndex
+    size_t memoryLimit = 0;     // bytes of the families in flight and the k-mer tables, 0 for no limit, see MemoryBudget
+    int relayoutLevels = -1;    // levels of a built suffix tree laid out breadth first, -1 keeps the construction order, see SuffixTree::relayout
+    bool forwardStrandOnly = false; // alignment free discovery indexes only the genes and matches the reverse complement of every motif as well
+    bool kmerTable = false;     // alignment free discovery fills a KmerTable per family instead of building a suffix tree
+    int constructionThreads = 1; // threads that build one suffix tree, more than 1 partitions the suffixes, see SuffixTree::constructPartitioned
+};
+
+// one orthologous family as read from the input, with everything needed to build its suffix tree
+struct OrthoFamily {
+    std::string name;
+    int N;                      // number of species
+    std::string T;              // all genes and their reverse complement, separated by delimiters
+    bool hasReverseComplement = true; // false if T only holds the genes, see RunOptions::forwardStrandOnly
+    std::vector<size_t> stringStartPositions;
+    std::vector<size_t> next_gene_locations;
+    std::vector<std::string> gene_names;
+    std::vector<size_t> order_of_species_mapping;
+    std::unique_ptr<BLSScore> bls;
+    FamilyStats stats;          // parse and bls preparation are filled in by readFamily
+};
+
 class GeneFamily {
 private:
 
     static const std::unordered_set<char> validCharacters;
 
     static size_t getIndexOfVector(const std::vector<std::string> &v, const std::string &val);
+    static void locateMotifs(std::istream& ifs, const std::vector<float> blsThresholds_, const std::pair<short, short> l,
+        const int maxDegeneration, const float min_bls, const RunOptions& options, RunStats& stats, ProgressReporter& progress, std::ostream& out);
 public:
+    /**
+     * Reads the next family from the input
+     * @param forwardStrandOnly T only holds the genes, not their reverse complement
+     * @return false if there are no more families
+     */
+    static bool readFamily(std::istream& ifs, const std::vector<float>& blsThresholds_, OrthoFamily& family, const bool forwardStrandOnly = false);
+
     static void readOrthologousFamily(const int mode, const std::string& filename, const std::vector<float> blsThresholds_,
-        const Alphabet alphabet, const int type, const std::pair<short, short> l, const int maxDegeneration, const bool countBls, const float min_bls = 0.0f);
+        const Alphabet alphabet, const int type, const std::pair<short, short> l, const int maxDegeneration, const bool countBls, const float min_bls = 0.0f,
+        const RunOptions& options = RunOptions());
 
     static void readOrthologousFamily(const int mode, std::istream& ifs, const std::vector<float> blsThresholds_,
-        const Alphabet alphabet, const int type, const std::pair<short, short> l, const int maxDegeneration, const bool countBls, const float min_bls = 0.0f);
+        const Alphabet alphabet, const int type, const std::pair<short, short> l, const int maxDegeneration, const bool countBls, const float min_bls = 0.0f,
+        const RunOptions& options = RunOptions());
 
     static void readGenes(std::istream& ifs, const int maxDegeneration, const short maxLen);
 };
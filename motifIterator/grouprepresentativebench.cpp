@@ -0,0 +1,23 @@
+#include <benchmark/benchmark.h>
+#include "benchaccess.h"
+
+// Motif::isGroupRepresentative on random motifs with up to 3 degenerate characters
+static void BM_IsGroupRepresentative(benchmark::State& state) {
+    GeneratorConfig config;
+    SyntheticGenerator generator(config);
+    std::vector<std::string> motifs;
+    for (int i = 0; i < 4096; i++) {
+        motifs.push_back(generator.randomMotif(state.range(0), 3));
+    }
+    for (auto _ : state) {
+        int representatives = 0;
+        for (const std::string& motif : motifs) {
+            representatives += Motif::isGroupRepresentative(motif);
+        }
+        benchmark::DoNotOptimize(representatives);
+    }
+    state.SetItemsProcessed(state.iterations() * motifs.size());
+}
+BENCHMARK(BM_IsGroupRepresentative)->DenseRange(6, 12, 2);
+
+BENCHMARK_MAIN();
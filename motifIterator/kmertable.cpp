@@ -0,0 +1,170 @@
+#include <algorithm>
+#include "kmertable.h"
+
+// 2 bits per base, -1 for the characters that end a window
+static int baseCode(const char c) {
+    switch (c) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return -1;
+    }
+}
+
+const int KmerTable::MAX_LENGTH; // std::min takes it by reference
+
+KmerTable::KmerTable(const int maxLength_) : maxLength(std::min(maxLength_, MAX_LENGTH)), tables(maxLength + 1), touched(maxLength + 1), instances(maxLength + 1) {
+    for (int j = 1; j <= maxLength; j++)
+        tables[j].resize((size_t)16 << (2 * (j - 1)));
+}
+
+void KmerTable::add(const int length, const uint32_t kmer, const occurence_bits bit) {
+    occurence_bits* entries = &tables[length][(size_t)(kmer >> 2) * 16];
+    if ((entries[1] | entries[2] | entries[4] | entries[8]) == 0)
+        touched[length].push_back(kmer >> 2);
+    entries[1 << (kmer & 3)] |= bit;
+}
+
+void KmerTable::build(const std::string& T, const bool hasReverseComplement, const std::vector<size_t>& stringStartPositions,
+    const std::vector<size_t>& order_of_species_mapping) {
+    for (int j = 1; j <= maxLength; j++) {
+        for (uint32_t prefix : touched[j])
+            std::fill_n(&tables[j][(size_t)prefix * 16], 16, 0);
+        touched[j].clear();
+    }
+    const int reverseComplementFactor = hasReverseComplement ? 2 : 1;
+    const uint32_t window = ((uint64_t)1 << (2 * maxLength)) - 1;
+    uint32_t kmer = 0, reverseComplement = 0; // the last maxLength bases and their reverse complement
+    int run = 0; // bases since the last character that is not a base
+    size_t string = 0;
+    for (size_t i = 0; i < T.size(); i++) {
+        while (string + 1 < stringStartPositions.size() && stringStartPositions[string + 1] <= i)
+            string++;
+        int base = baseCode(T[i]);
+        if (base < 0) {
+            run = 0;
+            continue;
+        }
+        occurence_bits bit = 1 << order_of_species_mapping[string / reverseComplementFactor];
+        kmer = ((kmer << 2) | base) & window;
+        reverseComplement = (reverseComplement >> 2) | ((uint32_t)(3 - base) << (2 * (maxLength - 1)));
+        run = std::min(run + 1, maxLength);
+        for (int j = 1; j <= run; j++) {
+            add(j, kmer & (((uint64_t)1 << (2 * j)) - 1), bit);
+            if (!hasReverseComplement)
+                add(j, reverseComplement >> (2 * (maxLength - j)), bit);
+        }
+    }
+    // superset transform over the last base: the entry of a mask is the union of the entries of its bases
+    for (int j = 1; j <= maxLength; j++) {
+        for (uint32_t prefix : touched[j]) {
+            occurence_bits* entries = &tables[j][(size_t)prefix * 16];
+            for (int mask = 3; mask < 16; mask++) {
+                if ((mask & (mask - 1)) != 0)
+                    entries[mask] = entries[mask & (mask - 1)] | entries[mask & -mask];
+            }
+        }
+    }
+}
+
+/**
+The same enumeration as SuffixTree::enumerateMotifs, with the exact instances of a prefix as 2 bit codes instead of suffix tree positions.
+The occurence of an extension is the union of the table entries of its instances, the instances of the extension are only listed
+if it is extended further.
+*/
+template<Alphabet A, bool countBls>
+void KmerTable::enumerateMotifs(const std::pair<short, short>& l, const int& maxDegenerateLetters, const BLSScore& bls,
+    MyMotifMap* motifmap, std::ostream& out)
+{
+    std::vector<EnumerationFrame> frames(l.second + 1);
+    std::string motif; // the prefix of frame d is motif[0, d[
+    motif.reserve(l.second);
+    int depth = 0;
+    frames[0].next = 0;
+    frames[0].degenerateLetters = 0;
+    frames[0].extensions = (maxDegenerateLetters == 0) ? exactExtensions : extensionCount<A>;
+    instances[0].assign(1, 0);
+    nodesVisited++;
+
+    while (depth >= 0) {
+        EnumerationFrame& frame = frames[depth];
+        if (frame.next == frame.extensions) { // all extensions of this prefix are done
+            depth--;
+            continue;
+        }
+        const int e = frame.next++;
+        const bool degenerate = e >= exactExtensions;
+        GroupBalance balance = frame.balance;
+        balance.add(extensionList[e].getRepresentation());
+        if(!(depth + 1 >= l.first && balance.isRepresentative()) && !(depth + 2 < l.second && balance.canBecomeRepresentative(l.second - 2 - depth)))
+            continue;
+        const int mask = extensionList[e].getMask();
+        const std::vector<occurence_bits>& table = tables[depth + 1];
+        positionsAdvanced += instances[depth].size();
+        occurence_bits occurence = 0;
+        for (uint32_t prefix : instances[depth])
+            occurence |= table[(size_t)prefix * 16 + mask];
+        if(occurence == 0) // no instance occurs
+            continue;
+        motif.resize(depth);
+        motif.push_back(extensionList[e].getRepresentation());
+        iteratorCount++;
+        if(!bls.greaterThanMinThreshold(occurence))
+            continue;
+        if((unsigned char) motif.length() >= l.first && balance.isRepresentative()) {
+            if (countBls) {
+                motifmap->addMotifToMap(motif, bls.getBLSVector(occurence)[0]);
+            } else {
+                Motif::writeGroupIDAndMotifInBinary(motif, l.second, out);
+                bls.writeBLSVectorInBinary(occurence, out);
+            }
+            motifCount++;
+        }
+        if((unsigned char) motif.length() +  1 == l.second) // max length reached, we do not extend this motif
+            continue;
+        std::vector<uint32_t>& next = instances[depth + 1];
+        next.clear();
+        for (uint32_t prefix : instances[depth]) {
+            for (int base = 0; base < 4; base++) {
+                if ((mask & (1 << base)) && table[(size_t)prefix * 16 + (1 << base)] != 0)
+                    next.push_back(prefix * 4 + base);
+            }
+        }
+        EnumerationFrame& child = frames[++depth];
+        child.next = 0;
+        child.degenerateLetters = frame.degenerateLetters + degenerate;
+        child.extensions = (child.degenerateLetters == maxDegenerateLetters) ? exactExtensions : extensionCount<A>;
+        child.balance = balance;
+        nodesVisited++;
+    }
+}
+
+int KmerTable::printMotifs(const std::pair<short, short>& l, const Alphabet alphabet, const int& maxDegenerateLetters, const BLSScore& bls,
+    MyMotifMap* motifmap, std::ostream& out)
+{
+    motifCount = 0;
+    iteratorCount = 0;
+    nodesVisited = 0;
+    positionsAdvanced = 0;
+    if (l.second - 1 > maxLength) {
+        std::cerr << "motifs of length " << l.second - 1 << " are longer than the k-mer table" << std::endl;
+        return 0;
+    }
+    if (motifmap != NULL) {
+        switch(alphabet) {
+            case EXACT: enumerateMotifs<EXACT, true>(l, maxDegenerateLetters, bls, motifmap, out); break;
+            case EXACTANDN: enumerateMotifs<EXACTANDN, true>(l, maxDegenerateLetters, bls, motifmap, out); break;
+            case TWOFOLDSANDN: enumerateMotifs<TWOFOLDSANDN, true>(l, maxDegenerateLetters, bls, motifmap, out); break;
+            default: enumerateMotifs<ALL, true>(l, maxDegenerateLetters, bls, motifmap, out); break;
+        }
+    } else {
+        switch(alphabet) {
+            case EXACT: enumerateMotifs<EXACT, false>(l, maxDegenerateLetters, bls, motifmap, out); break;
+            case EXACTANDN: enumerateMotifs<EXACTANDN, false>(l, maxDegenerateLetters, bls, motifmap, out); break;
+            case TWOFOLDSANDN: enumerateMotifs<TWOFOLDSANDN, false>(l, maxDegenerateLetters, bls, motifmap, out); break;
+            default: enumerateMotifs<ALL, false>(l, maxDegenerateLetters, bls, motifmap, out); break;
+        }
+    }
+    return motifCount;
+}
@@ -0,0 +1,63 @@
+#ifndef KMERTABLE_H
+#define KMERTABLE_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "suffixtree.h"
+
+/**
+ * Alignment free motif discovery for short motifs without a suffix tree. One scan of T fills a dense table per length j
+ * with the occurence of every exact j-mer, 2 bits per base. The table of length j holds, for every (j-1)-mer and every
+ * mask of bases, the union of the occurences of the j-mers that continue it with one of these bases: a superset transform
+ * over the last base, so a degenerate letter is added with one lookup per exact instance of the motif.
+ * The motifs are enumerated in the same order as SuffixTree::printMotifs and written the same way.
+ * The tables take 16 * 4^(j-1) occurences per length, they are kept for the next family and only the entries that were set are cleared.
+ */
+class KmerTable {
+private:
+    const int maxLength;
+    std::vector<std::vector<occurence_bits>> tables; // tables[j][prefix * 16 + mask] for j = 1 .. maxLength
+    std::vector<std::vector<uint32_t>> touched;      // the prefixes that have entries in tables[j]
+    std::vector<std::vector<uint32_t>> instances;    // per motif character: the exact instances of the prefix
+    size_t motifCount = 0;
+    size_t iteratorCount = 0;
+    size_t nodesVisited = 0;
+    size_t positionsAdvanced = 0;
+
+    void add(const int length, const uint32_t kmer, const occurence_bits bit);
+
+    template<Alphabet A, bool countBls>
+    void enumerateMotifs(const std::pair<short, short>& l, const int& maxDegenerateLetters, const BLSScore& bls,
+        MyMotifMap* motifmap, std::ostream& out);
+
+public:
+    static const int MAX_LENGTH = 11; // the longest motif, 85MB of tables
+
+    /**
+     * @param maxLength_ the longest motif, at most MAX_LENGTH
+     */
+    KmerTable(const int maxLength_);
+    KmerTable(const KmerTable&) = delete;
+    KmerTable& operator=(const KmerTable&) = delete;
+
+    /**
+     * Replaces the tables with the windows of T, the species of a string are found as in the suffix tree
+     * @param hasReverseComplement T holds the reverse complement of every gene, if not the reverse complement of every window is added as well
+     */
+    void build(const std::string& T, const bool hasReverseComplement, const std::vector<size_t>& stringStartPositions,
+        const std::vector<size_t>& order_of_species_mapping);
+
+    /**
+     * Same as SuffixTree::printMotifs in alignment free mode, the motifs are added to motifmap if it is not NULL
+     * @return number of motifs written
+     */
+    int printMotifs(const std::pair<short, short>& l, const Alphabet alphabet, const int& maxDegenerateLetters, const BLSScore& bls,
+        MyMotifMap* motifmap, std::ostream& out);
+
+    size_t getMotifsIteratedCount() const { return iteratorCount; }
+    size_t getNodesVisitedCount() const { return nodesVisited; }
+    size_t getPositionsAdvancedCount() const { return positionsAdvanced; }
+};
+
+#endif
@@ -22,11 +22,77 @@
 #include <bitset>
 #include "suffixtree.h"
 #include "genefamily.h"
+#include "memorybudget.h"
 
 using namespace std;
 
+/**
+ * Removes the options (--name value) from the arguments, the positional arguments keep their order
+ * @return the number of positional arguments (including the program name), -1 if an option is invalid
+ */
+int parseOptions(int argc, char* argv[], RunOptions& options)
+{
+        int positional = 1;
+        for (int i = 1; i < argc; i++) {
+            if (strncmp(argv[i], "--", 2) != 0) {
+                argv[positional++] = argv[i];
+            } else if (strcmp(argv[i], "--resume") == 0) { // the only option without a value
+                options.resume = true;
+            } else if (i + 1 == argc) {
+                std::cerr << "missing value for option " << argv[i] << std::endl;
+                return -1;
+            } else if (strcmp(argv[i], "--threads") == 0) {
+                options.threads = std::max(1, std::stoi(argv[++i]));
+            } else if (strcmp(argv[i], "--build-threads") == 0) {
+                options.buildThreads = std::max(1, std::stoi(argv[++i]));
+            } else if (strcmp(argv[i], "--iterate-threads") == 0) {
+                options.iterateThreads = std::max(1, std::stoi(argv[++i]));
+            } else if (strcmp(argv[i], "--position-format") == 0) {
+                options.binaryPositions = strcmp(argv[++i], "binary") == 0;
+            } else if (strcmp(argv[i], "--stats") == 0) {
+                options.statsFile = argv[++i];
+            } else if (strcmp(argv[i], "--progress") == 0) {
+                options.progressInterval = std::stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--output") == 0) {
+                options.outputFile = argv[++i];
+            } else if (strcmp(argv[i], "--checkpoint") == 0) {
+                options.checkpointFile = argv[++i];
+            } else if (strcmp(argv[i], "--checkpoint-interval") == 0) {
+                options.checkpointInterval = std::stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--index") == 0) {
+                options.indexFile = argv[++i];
+            } else if (strcmp(argv[i], "--save-index") == 0) {
+                options.saveIndexFile = argv[++i];
+            } else if (strcmp(argv[i], "--relayout") == 0) {
+                options.relayoutLevels = std::stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--strands") == 0) {
+                options.forwardStrandOnly = strcmp(argv[++i], "forward") == 0;
+            } else if (strcmp(argv[i], "--engine") == 0) {
+                options.kmerTable = strcmp(argv[++i], "kmer") == 0;
+            } else if (strcmp(argv[i], "--construction-threads") == 0) {
+                options.constructionThreads = std::stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--memory-limit") == 0) {
+                options.memoryLimit = MemoryBudget::parseSize(argv[++i]);
+                if (options.memoryLimit == 0) {
+                        std::cerr << "invalid memory limit " << argv[i] << std::endl;
+                        return -1;
+                }
+            } else {
+                std::cerr << "unknown option " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        if (options.resume && options.checkpointFile.empty()) {
+                std::cerr << "--resume needs --checkpoint" << std::endl;
+                return -1;
+        }
+        return positional;
+}
+
 int main(int argc, char* argv[])
 {
+        RunOptions options;
+        argc = parseOptions(argc, argv, options);
         if (argc == 8 || argc == 9) {
             int mode = 0; // motif discovery
             int type = -1; // error if not given properly!
@@ -56,9 +122,9 @@ int main(int argc, char* argv[])
             bool countBls = (argc == 9 ? (strcmp(argv[8], "true") == 0) : false);
 
             if ((strcmp(argv[1], "-") == 0))
-                GeneFamily::readOrthologousFamily(mode, std::cin, blsThresholds, alphabet, type, l, maxDegeneration, countBls);
+                GeneFamily::readOrthologousFamily(mode, std::cin, blsThresholds, alphabet, type, l, maxDegeneration, countBls, 0.0f, options);
             else
-                GeneFamily::readOrthologousFamily(mode, argv[1], blsThresholds, alphabet, type, l, maxDegeneration, countBls);
+                GeneFamily::readOrthologousFamily(mode, argv[1], blsThresholds, alphabet, type, l, maxDegeneration, countBls, 0.0f, options);
         } else if (argc == 6 || argc == 7) {
             int mode = 1; // find motif location
             int type = -1; // error if not given properly!
@@ -87,9 +153,9 @@ int main(int argc, char* argv[])
             float min_bls = (argc == 7 ? std::stof(argv[6]) : 0);
 
             if ((strcmp(argv[1], "-") == 0))
-                GeneFamily::readOrthologousFamily(mode, std::cin, blsThresholds, alphabet, type, l, maxDegeneration, false, min_bls);
+                GeneFamily::readOrthologousFamily(mode, std::cin, blsThresholds, alphabet, type, l, maxDegeneration, false, min_bls, options);
             else
-                GeneFamily::readOrthologousFamily(mode, argv[1], blsThresholds, alphabet, type, l, maxDegeneration, false, min_bls);
+                GeneFamily::readOrthologousFamily(mode, argv[1], blsThresholds, alphabet, type, l, maxDegeneration, false, min_bls, options);
         } else {
             std::cerr << "usage: " << std::endl;
             std::cerr << "DISCOVERY: ./motifIterator input type alphabet blsThresholdList degeneration minlen maxlen [countBls]" << std::endl;
@@ -102,11 +168,28 @@ int main(int argc, char* argv[])
             std::cerr << "\tmaxlen:\tMaximum motif length, non inclusive (i.e. length < maxlen)." << std::endl;
             std::cerr << "\tcountBls:\tIndicates whether valid motifs per BLS threshold should be counted. true or [false]." << std::endl;
             std::cerr << "MATCH MOTIFS: ./motifIterator input type blsThresholdList degeneration maxlen [bls_threshold]" << std::endl;
-            std::cerr << "\tinput:\tInput file or '-' for stdin: ortho group file followed by a list of sorted motifs to find" << std::endl;
+            std::cerr << "\tinput:\tInput file or '-' for stdin: ortho group file followed by a list of motifs to find (any order, located motifs are written in sorted order)" << std::endl;
             std::cerr << "\ttype:\tAB or AF for alignment based or alignment free motif discovery" << std::endl;
             std::cerr << "\tblsThresholdList:\tComma sepparated list of bls thresholds (between 0 to 1). Example '0.15,0.5,0.6,0.7,0.9,0.95'" << std::endl;
             std::cerr << "\tdegeneration:\tNumber of degenerate characters." << std::endl;
             std::cerr << "\tmaxlen:\tMaximum motif length, non inclusive (i.e. length < maxlen)." << std::endl;
+            std::cerr << "OPTIONS: can be given anywhere on the command line" << std::endl;
+            std::cerr << "\t--threads n:\tNumber of threads used to locate motifs [1]." << std::endl;
+            std::cerr << "\t--build-threads n:\tDiscovery only: number of threads that build suffix trees while others iterate [1]." << std::endl;
+            std::cerr << "\t--iterate-threads n:\tDiscovery only: number of threads that iterate over the motifs, the output stays in input order [1]." << std::endl;
+            std::cerr << "\t--position-format text|binary:\tFormat of the located motif positions [text]." << std::endl;
+            std::cerr << "\t--stats file:\tWrite the time per phase and the counters of every family and of the whole run as json lines." << std::endl;
+            std::cerr << "\t--progress seconds:\tReport families done, input read, motifs per second and the estimated time left every n seconds [0: off]." << std::endl;
+            std::cerr << "\t--output file:\tWrite the output to a file instead of stdout." << std::endl;
+            std::cerr << "\t--checkpoint file:\tDiscovery only: save the progress (and the bls counts) after a family, at most every --checkpoint-interval seconds [600]." << std::endl;
+            std::cerr << "\t--resume:\tContinue from the --checkpoint file, with the same arguments. The --output file is truncated to the checkpoint." << std::endl;
+            std::cerr << "\t--save-index file:\tLocation only: write the suffix trees of all families to an index file." << std::endl;
+            std::cerr << "\t--index file:\tLocation only: map the suffix trees from an index file instead of building them, families that are not in it are built." << std::endl;
+            std::cerr << "\t--relayout levels:\tCopy every built suffix tree into one block, the top levels breadth first and the rest depth first [off]." << std::endl;
+            std::cerr << "\t--strands both|forward:\tAlignment free discovery only: index only the genes and match the reverse complement of every motif as well, which halves the suffix trees [both]." << std::endl;
+            std::cerr << "\t--engine tree|kmer:\tAlignment free discovery only: count the motifs in a suffix tree or in a dense table of the k-mers of every length, for motifs up to length 11 [tree]." << std::endl;
+            std::cerr << "\t--construction-threads n:\tBuild every suffix tree on n threads, one sub-tree per first two characters [1]." << std::endl;
+            std::cerr << "\t--memory-limit size:\tOnly process families in parallel while their estimated memory fits, e.g. 16G. Larger families run alone." << std::endl;
             return EXIT_FAILURE;
         }
         return EXIT_SUCCESS;
@@ -0,0 +1,67 @@
+#include <cmath>
+#include <algorithm>
+#include "memorybudget.h"
+#include "suffixtree.h"
+#include "kmertable.h"
+
+size_t MemoryBudget::estimateFamily(const size_t textLength, const short maxLength, const int maxDegeneration) {
+    const size_t nodeBytes = sizeof(STNode) + sizeof(STNodeLinks); // the links are dropped when the tree is built
+    size_t tree = textLength * (2 * nodeBytes + sizeof(TextPosition) + sizeof(length_t) + 2); // T is kept by the family and the tree
+    // alignment based iteration keeps a suffix index and two occurence columns per position
+    size_t occurrences = textLength * (sizeof(size_t) + 2 * sizeof(occurence_bits));
+    size_t positionLists = (maxLength + 1) * (size_t)std::pow(4, std::min((int)maxLength, maxDegeneration)) * sizeof(STPosition);
+    return tree + occurrences + positionLists;
+}
+
+size_t MemoryBudget::estimateKmerTable(const int maxLength) {
+    size_t prefixes = 0; // 4^(j-1) prefixes of length j - 1, each with 16 masks
+    for (int j = 1; j <= std::min(maxLength, KmerTable::MAX_LENGTH); j++)
+        prefixes += (size_t)1 << (2 * (j - 1));
+    return prefixes * (16 * sizeof(occurence_bits) + sizeof(uint32_t));
+}
+
+void MemoryBudget::reserve(const size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    used += bytes;
+    reserved += bytes;
+}
+
+void MemoryBudget::acquire(const size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [&]() { return fits(bytes); });
+    used += bytes;
+}
+
+bool MemoryBudget::tryAcquire(const size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!fits(bytes))
+        return false;
+    used += bytes;
+    return true;
+}
+
+void MemoryBudget::release(const size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        used -= bytes;
+    }
+    released.notify_all();
+}
+
+size_t MemoryBudget::parseSize(const std::string& size) {
+    size_t end = 0;
+    double value;
+    try {
+        value = std::stod(size, &end);
+    } catch (const std::exception&) {
+        return 0;
+    }
+    std::string unit = size.substr(end);
+    std::transform(unit.begin(), unit.end(), unit.begin(), ::toupper);
+    if (unit == "K" || unit == "KB") value *= 1024.0;
+    else if (unit == "M" || unit == "MB") value *= 1024.0 * 1024;
+    else if (unit == "G" || unit == "GB") value *= 1024.0 * 1024 * 1024;
+    else if (unit == "T" || unit == "TB") value *= 1024.0 * 1024 * 1024 * 1024;
+    else if (!unit.empty()) return 0;
+    return value < 0 ? 0 : (size_t)value;
+}
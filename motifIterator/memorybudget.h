@@ -0,0 +1,49 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <mutex>
+#include <condition_variable>
+#include <string>
+
+/**
+ * Admits families into processing while the sum of their estimated memory stays under a limit.
+ * A family that needs more than the limit on its own is admitted when nothing else is in flight, so it runs alone.
+ * The motif map of countBls grows over the whole run and is not part of the budget.
+ */
+class MemoryBudget {
+private:
+    const size_t limit;                 // bytes, 0 for no limit
+    size_t used = 0;
+    size_t reserved = 0;                // part of used that is held for the whole run
+    std::mutex mutex;
+    std::condition_variable released;
+
+    bool fits(const size_t bytes) const { return limit == 0 || used == reserved || used + bytes <= limit; }
+public:
+    MemoryBudget(const size_t limit_) : limit(limit_) {}
+
+    /**
+     * Estimated peak memory of one family: its suffix tree (at most 2 nodes per character of T), the text positions
+     * and the position lists of the motif iteration, which grow with 4^maxDegeneration
+     */
+    static size_t estimateFamily(const size_t textLength, const short maxLength, const int maxDegeneration);
+    // memory of one KmerTable for motifs up to maxLength: the tables and the lists of their prefixes
+    static size_t estimateKmerTable(const int maxLength);
+
+    bool isLimited() const { return limit > 0; }
+    // holds memory until the end of the run, a family that does not fit in the rest of the limit still runs alone
+    void reserve(const size_t bytes);
+    // waits until the family fits
+    void acquire(const size_t bytes);
+    // does not wait
+    bool tryAcquire(const size_t bytes);
+    void release(const size_t bytes);
+
+    /**
+     * Parses a size such as 4096, 512M or 16G
+     * @return 0 if the size is not valid
+     */
+    static size_t parseSize(const std::string& size);
+};
+
+#endif
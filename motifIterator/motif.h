@@ -69,6 +69,50 @@ public:
     static void writeMotif(const std::string& motif, std::ostream& out);
 };
 
+/**
+ * The number of every letter minus the number of its complement in a motif, for the pairs in the order of the group ids.
+ * The group id is the sorted motif, so the first pair that differs tells which of a motif and its reverse complement
+ * has the smaller group id: Motif::isGroupRepresentative is known while the motif is extended one letter at a time.
+ */
+struct GroupBalance {
+    static const int PAIRS = 6; // A-T, B-V, C-G, D-H, K-M, R-Y, the other letters are their own complement
+    short difference[PAIRS] = {};
+
+    void add(const char c) {
+        switch (c) {
+            case 'A': difference[0]++; break;
+            case 'T': difference[0]--; break;
+            case 'B': difference[1]++; break;
+            case 'V': difference[1]--; break;
+            case 'C': difference[2]++; break;
+            case 'G': difference[2]--; break;
+            case 'D': difference[3]++; break;
+            case 'H': difference[3]--; break;
+            case 'K': difference[4]++; break;
+            case 'M': difference[4]--; break;
+            case 'R': difference[5]++; break;
+            case 'Y': difference[5]--; break;
+        }
+    }
+    // same as Motif::isGroupRepresentative
+    bool isRepresentative() const {
+        return canBecomeRepresentative(0);
+    }
+    /**
+     * Whether some motif with at most letters more letters is a group representative: appending only A's is the best
+     * extension, it only increases the first difference
+     */
+    bool canBecomeRepresentative(const int letters) const {
+        if (difference[0] + letters != 0)
+            return difference[0] + letters > 0;
+        for (int i = 1; i < PAIRS; i++) {
+            if (difference[i] != 0)
+                return difference[i] > 0;
+        }
+        return true;
+    }
+};
+
 // class MotifCollection {
 // private:
 //     std::unordered_set<std::string> processedMotifs; // average constant time adding + searching!
@@ -199,10 +243,10 @@ public:
     static const char DELIMITER = '$';
     static const std::vector<IupacMask> characterToMask;
     static const std::vector<char> representation;
-    IupacMask() : mask(0) {}
-    IupacMask(const IUPAC mask_ ) : mask(mask_) {}
+    constexpr IupacMask() : mask(0) {}
+    constexpr IupacMask(const IUPAC mask_ ) : mask(mask_) {}
 
-    unsigned char getMask() const { return mask; }
+    constexpr unsigned char getMask() const { return mask; }
 
     bool isDegenerate() {
         return __builtin_popcountll(mask) > 1; // relies on the gcc builtin popcount
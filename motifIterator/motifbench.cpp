@@ -0,0 +1,176 @@
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+#include <sys/resource.h>
+#include "benchgenerator.h"
+#include "genefamily.h"
+#include "kmertable.h"
+
+using namespace std;
+
+// discards the output of a scenario, only the number of bytes is kept
+class CountingBuffer : public std::streambuf {
+public:
+        size_t bytes = 0;
+protected:
+        int overflow(int c) override { bytes++; return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { bytes += n; return n; }
+};
+
+struct ScenarioResult {
+        std::string name;
+        double seconds = 0;
+        size_t families = 0;
+        size_t motifs = 0;          // valid motifs for discovery, located query motifs for location
+        size_t iterated = 0;        // iterated motifs for discovery, visited query trie nodes for location
+        size_t outputBytes = 0;
+        long peakRssKb = 0;
+};
+
+static const std::vector<float> blsThresholds = {0.15f, 0.5f, 0.6f, 0.7f, 0.9f, 0.95f};
+
+/**
+ * Runs motif discovery on every family of the input, the same way motifIterator does
+ * @param forwardStrandOnly index only the genes, as with --strands forward
+ * @param kmerTable alignment free only: use a KmerTable instead of a suffix tree, as with --engine kmer
+ */
+static void runDiscovery(const std::string& input, const bool alignmentBased, const Alphabet alphabet, const int maxDegeneration,
+        const std::pair<short, short> l, const bool countBls, ScenarioResult& result, const bool forwardStrandOnly = false, const bool kmerTable = false)
+{
+        CountingBuffer buffer;
+        std::ostream out(&buffer);
+        std::istringstream in(input);
+        MyMotifMap motifmap((char)blsThresholds.size(), l);
+        OrthoFamily family;
+        std::unique_ptr<KmerTable> table(kmerTable ? new KmerTable(l.second - 1) : NULL);
+        while (GeneFamily::readFamily(in, blsThresholds, family, forwardStrandOnly)) {
+            if (table) {
+                table->build(family.T, family.hasReverseComplement, family.stringStartPositions, family.order_of_species_mapping);
+                result.motifs += table->printMotifs(l, alphabet, maxDegeneration, *family.bls, countBls ? &motifmap : NULL, out);
+                result.iterated += table->getMotifsIteratedCount();
+                result.families++;
+                continue;
+            }
+            SuffixTree ST(family.T, family.name, family.hasReverseComplement, family.stringStartPositions, family.gene_names, family.next_gene_locations,
+                family.order_of_species_mapping, countBls ? &motifmap : NULL);
+            result.motifs += ST.printMotifs(l, alphabet, maxDegeneration, *family.bls, out, alignmentBased);
+            result.iterated += ST.getMotifsIteratedCount();
+            result.families++;
+        }
+        long unique_count = 0;
+        motifmap.recPrintAndDelete(unique_count, out);
+        result.outputBytes = buffer.bytes;
+}
+
+/**
+ * Locates the query motifs that follow every family, the same way location mode does
+ */
+static void runLocation(const std::string& input, const int maxDegeneration, ScenarioResult& result)
+{
+        CountingBuffer buffer;
+        std::ostream out(&buffer);
+        std::istringstream in(input);
+        OrthoFamily family;
+        while (GeneFamily::readFamily(in, blsThresholds, family)) {
+            MotifTrie trie;
+            result.motifs += trie.readMotifs(in);
+            result.iterated += trie.size();
+            SuffixTree ST(family.T, family.name, true, family.stringStartPositions, family.gene_names, family.next_gene_locations,
+                family.order_of_species_mapping, NULL);
+            ST.matchMotifTrie(trie, out, *family.bls, maxDegeneration, 0.0f);
+            result.families++;
+        }
+        result.outputBytes = buffer.bytes;
+}
+
+static ScenarioResult runScenario(const std::string& name, const GeneratorConfig& config)
+{
+        ScenarioResult result;
+        result.name = name;
+        SyntheticGenerator generator(config);
+        // the input is generated before the clock starts
+        std::string input = generator.generate(name == "ab", name == "locate");
+        auto start = std::chrono::steady_clock::now();
+        if (name == "af") {
+            runDiscovery(input, false, TWOFOLDSANDN, 1, std::make_pair<short, short>(6, 10), false, result);
+        } else if (name == "af-forward") {
+            runDiscovery(input, false, TWOFOLDSANDN, 1, std::make_pair<short, short>(6, 10), false, result, true);
+        } else if (name == "af-kmer") {
+            runDiscovery(input, false, TWOFOLDSANDN, 1, std::make_pair<short, short>(6, 10), false, result, false, true);
+        } else if (name == "ab") {
+            runDiscovery(input, true, TWOFOLDSANDN, 1, std::make_pair<short, short>(6, 10), false, result);
+        } else if (name == "count") {
+            runDiscovery(input, false, TWOFOLDSANDN, 1, std::make_pair<short, short>(8, 9), true, result);
+        } else if (name == "locate") {
+            runLocation(input, 3, result);
+        } else {
+            throw std::runtime_error("unknown scenario " + name);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        result.seconds = elapsed.count();
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        result.peakRssKb = usage.ru_maxrss;
+        return result;
+}
+
+static void writeJson(std::ostream& out, const GeneratorConfig& config, const std::vector<ScenarioResult>& results)
+{
+        out << "{\"config\": {\"families\": " << config.families << ", \"species\": " << config.species
+            << ", \"genes_per_species\": " << config.genesPerSpecies << ", \"sequence_length\": " << config.sequenceLength
+            << ", \"repeat_fraction\": " << config.repeatFraction << ", \"planted_motifs\": " << config.plantedMotifs
+            << ", \"planted_length\": " << config.plantedLength << ", \"mutation_rate\": " << config.mutationRate
+            << ", \"queries\": " << config.queries << ", \"seed\": " << config.seed << "},\n \"scenarios\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const ScenarioResult& r = results[i];
+            out << (i > 0 ? "," : "") << "\n  {\"name\": \"" << r.name << "\", \"seconds\": " << r.seconds
+                << ", \"families\": " << r.families << ", \"motifs\": " << r.motifs
+                << ", \"motifs_per_s\": " << r.motifs / r.seconds << ", \"iterated\": " << r.iterated
+                << ", \"iterated_per_s\": " << r.iterated / r.seconds << ", \"output_bytes\": " << r.outputBytes
+                << ", \"peak_rss_kb\": " << r.peakRssKb << "}";
+        }
+        out << "\n]}" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+        GeneratorConfig config;
+        std::vector<std::string> scenarios = {"af", "ab", "count", "locate"};
+        for (int i = 1; i < argc; i++) {
+            if (i + 1 == argc) {
+                std::cerr << "missing value for option " << argv[i] << std::endl;
+                return EXIT_FAILURE;
+            }
+            std::string value = argv[i + 1];
+            if (strcmp(argv[i], "--scenarios") == 0) {
+                scenarios.clear();
+                std::istringstream list(value);
+                for (std::string s; std::getline(list, s, ',');) scenarios.push_back(s);
+            } else if (strcmp(argv[i], "--families") == 0) { config.families = std::stoi(value);
+            } else if (strcmp(argv[i], "--species") == 0) { config.species = std::min(N_BITS, std::stoi(value));
+            } else if (strcmp(argv[i], "--newick") == 0) { config.newick = value;
+            } else if (strcmp(argv[i], "--genes") == 0) { config.genesPerSpecies = std::stoi(value);
+            } else if (strcmp(argv[i], "--length") == 0) { config.sequenceLength = std::stoi(value);
+            } else if (strcmp(argv[i], "--repeats") == 0) { config.repeatFraction = std::stod(value);
+            } else if (strcmp(argv[i], "--planted") == 0) { config.plantedMotifs = std::stoi(value);
+            } else if (strcmp(argv[i], "--planted-length") == 0) { config.plantedLength = std::stoi(value);
+            } else if (strcmp(argv[i], "--mutation") == 0) { config.mutationRate = std::stod(value);
+            } else if (strcmp(argv[i], "--queries") == 0) { config.queries = std::stoi(value);
+            } else if (strcmp(argv[i], "--seed") == 0) { config.seed = std::stoul(value);
+            } else {
+                std::cerr << "usage: ./motifBench [--scenarios af,af-forward,af-kmer,ab,count,locate] [--families n] [--species n] [--newick tree]" << std::endl;
+                std::cerr << "\t[--genes n] [--length n] [--repeats fraction] [--planted n] [--planted-length n] [--mutation rate] [--queries n] [--seed n]" << std::endl;
+                std::cerr << "Runs the scenarios on synthetic ortho groups and writes the timings as json to stdout, peak_rss_kb is the peak of the process so far." << std::endl;
+                return EXIT_FAILURE;
+            }
+            i++;
+        }
+        std::vector<ScenarioResult> results;
+        for (const std::string& scenario : scenarios) {
+            std::cerr << "running " << scenario << std::endl;
+            results.push_back(runScenario(scenario, config));
+        }
+        writeJson(std::cout, config, results);
+        return EXIT_SUCCESS;
+}
@@ -4,6 +4,9 @@
 #include <algorithm>
 #include "motif.h"
 #include "suffixtree.h"
+#include "treeindex.h"
+#include "genefamily.h"
+#include "kmertable.h"
 
 
 class MotifIteratorTest: public ::testing::Test {
@@ -26,16 +29,17 @@ protected:
     std::string ZM = "TCTACGTACGTTCT";
     std::string BDAndRC = "ACGACGTACGTACG$CGTACGTACGTCGT$";
     std::string OSAndRC = "GCTACGTACGTGCT$AGCACGTACGTAGC$";
-    std::string SBAndRC = "AGTACGTACGTAGT$ACTACGTACGTACT$";
+    std::string SBAndRC = "AGTACGTACGTAGT$ACTACGTACGTACT$$";
     std::string ZMAndRC = "TCTACGTACGTTCT$AGAACGTACGTAGA$";
     std::vector<std::string> possible_motifs{"AACGTACG","ACGACGTA", "ACTACGTA", "AGAACGTA", "AGCACGTA", "AGTACGTA", "CACGTACG", "CGACGTAC", "CGTACGTC", "CGTACGTG", "CGTACGTT", "GAACGTAC", "GACGTACG", "GCACGTAC", "GCTACGTA", "GTACGTCG", "GTACGTGC", "GTACGTTC", "TACGTACT", "TACGTAGA", "TACGTAGC", "TACGTAGT", "TACGTCGT", "TACGTGCT", "TACGTTCT", "TCTACGTA"};
     std::vector<std::string> orthogroup{"TESTORTHO1", newick, "4", "BD\tBD", BD, "OS\tOS", OS, "ZM\tZM", ZM , "SB\tSB", SB};
-    std::string finalT = "ACGACGTACGTACG$CGTACGTACGTCGT$GCTACGTACGTGCT$AGCACGTACGTAGC$TCTACGTACGTTCT$AGAACGTACGTAGA$AGTACGTACGTAGT$ACTACGTACGTACT$";
+    std::string finalT = "ACGACGTACGTACG$CGTACGTACGTCGT$GCTACGTACGTGCT$AGCACGTACGTAGC$TCTACGTACGTTCT$AGAACGTACGTAGA$AGTACGTACGTAGT$ACTACGTACGTACT$$";
     std::string T;
     SuffixTree *ST = NULL;
     SuffixTree *STCounted = NULL;
     std::vector<size_t> stringStartPositions;
-    std::vector<size_t> finalStringStartPositions{0, 15, 30, 45, 60, 75, 90, 105, 120};
+    std::vector<size_t> finalStringStartPositions{0, 15, 30, 45, 60, 75, 90, 105, 121};
+    std::vector<size_t> finalNextGeneLocations{0, 15, 30, 45, 60, 75, 90, 105, 120}; // the start positions without the last delimiter
     std::vector<size_t> order_of_species_mapping;
     std::vector<size_t> final_order_of_species_mapping{0, 1, 3, 2};
     std::vector<size_t> next_gene_locations;// only needed for find motifs, is same as startpositions of only 1 gene per species (no paralogues)
@@ -142,6 +146,8 @@ protected:
             i++;
         }
         T.push_back(IupacMask::DELIMITER);
+        T.push_back(IupacMask::DELIMITER); // as GeneFamily::readFamily, every suffix of the last string gets a leaf
+        stringStartPositions.back() = T.size();
 
         motif_to_blsvector_map = new MyMotifMap(blsvectorsize, l);
         ST = new SuffixTree(T, name, true, stringStartPositions, gene_names, next_gene_locations, order_of_species_mapping, NULL);
@@ -221,6 +227,48 @@ std::vector<std::string> expand(std::string motif) {
     return currentlist;
 }
 
+// the private parts of SuffixTree the tests check
+struct SuffixTreeTestAccess {
+    // the motifs are written as text, group id, motif and bls vector separated by tabs
+    static void writeText(SuffixTree& tree) {
+        tree.binaryOutput = false;
+    }
+    // the best occurence of the positions from start on, accumulated in the reused buffers
+    static void getBestOccurence(SuffixTree& tree, const std::vector<size_t>& positions, const size_t start, const BLSScore& bls,
+            occurence_bits& occurence, LocationBuffers& buffers) {
+        tree.getBestOccurence(positions, start, bls, occurence, buffers);
+    }
+    // <string, column> of a position of T
+    static std::pair<int, int> getStringPosition(const SuffixTree& tree, const size_t p) {
+        return tree.getStringPosition(p);
+    }
+};
+
+// input of GeneFamily::readFamily for the species of MotifIteratorTest, the first gene of every species is read from a new line
+std::string orthoGroupInput(const std::string& name, const std::vector<std::string>& genes) {
+    std::string newick = "((BD:0.2688,OS:0.2688):0.0538,(SB:0.086,ZM:0.086):0.2366);";
+    std::vector<std::string> species{"BD", "OS", "ZM", "SB"};
+    std::string input = name + "\n" + newick + "\n" + std::to_string(genes.size()) + "\n";
+    for (size_t i = 0; i < genes.size(); i++)
+        input += species[i] + "\t" + species[i] + "\n" + genes[i] + "\n";
+    return input + "\n";
+}
+
+// the family with N runs and tandem repeats, the last species shares the start of its gene with an earlier one
+std::string repetitiveOrthoGroupInput() {
+    std::string tandem;
+    for (int i = 0; i < 50; i++)
+        tandem += "ACG";
+    return orthoGroupInput("REPEATS", {"ACGACGTACGTACG" + std::string(60, 'N') + tandem, "GCTACGTACGTGCTNNNNAGCTAGCT",
+        "TCTACGTACGTTCT" + std::string(30, 'A') + "CGTACG", "GCTACGTACGTAGTCGTACGTCGTTTT"});
+}
+
+// the suffix tree of a family read with GeneFamily::readFamily
+SuffixTree* buildTree(const OrthoFamily& family) {
+    return new SuffixTree(family.T, family.name, family.hasReverseComplement, family.stringStartPositions, family.gene_names,
+        family.next_gene_locations, family.order_of_species_mapping, NULL);
+}
+
 TEST_F (MotifIteratorTest, Setup) {
     ASSERT_EQ (order_of_species.size() , 4);
     ASSERT_EQ(final_order_of_species.size(), order_of_species.size());
@@ -236,9 +284,9 @@ TEST_F (MotifIteratorTest, Setup) {
     for(int i = 0; i < order_of_species_mapping.size(); i++ ) {
         ASSERT_EQ(final_order_of_species_mapping[i], order_of_species_mapping[i]);
     }
-    ASSERT_EQ(finalStringStartPositions.size(), next_gene_locations.size());
+    ASSERT_EQ(finalNextGeneLocations.size(), next_gene_locations.size());
     for(int i = 0; i < next_gene_locations.size(); i++ ) {
-        ASSERT_EQ(finalStringStartPositions[i], next_gene_locations[i]);
+        ASSERT_EQ(finalNextGeneLocations[i], next_gene_locations[i]);
     }
 }
 
@@ -375,6 +423,423 @@ TEST_F (MotifIteratorTest, IteratoreNoCountDegenerate) { // make sure print out
     }
 }
 
+TEST_F (MotifIteratorTest, LocateMotifsAnyOrder) { // shared prefixes are matched once, independent of the input order
+    std::string sorted = "ACGTACGT\t0\nACGTACG\t0\nACGTNCGT\t0\nCGTACGTA\t0\nTACGTAGT\t0\n\n";
+    std::string unsorted = "TACGTAGT\t0\nACGTNCGT\t0\nCGTACGTA\t0\nACGTACGT\t0\nACGTACG\t0\n\n";
+    std::istringstream sortedIn(sorted), unsortedIn(unsorted);
+    std::ostringstream sortedOut, unsortedOut;
+    ASSERT_EQ(ST->matchIupacPatterns(sortedIn, sortedOut, *bls, 1, 0.0f), 5);
+    ASSERT_EQ(ST->matchIupacPatterns(unsortedIn, unsortedOut, *bls, 1, 0.0f), 5);
+    ASSERT_EQ(sortedOut.str(), unsortedOut.str());
+    ASSERT_EQ(sortedOut.str().substr(0, sortedOut.str().find('\t')), "ACGTACG");
+}
+
+// the strings of T, forward and reverse complement of every species in the order of T, fillers are kept as delimiters
+std::vector<std::string> splitStrings(const std::string& T, const std::vector<size_t>& stringStartPositions) {
+    std::vector<std::string> strings;
+    for (size_t s = 0; s + 1 < stringStartPositions.size(); s++)
+        strings.push_back(T.substr(stringStartPositions[s], stringStartPositions[s + 1] - stringStartPositions[s] - 1));
+    return strings;
+}
+
+// <string, column> of every occurrence of an IUPAC motif, found by a scan of the strings
+std::vector<std::pair<int, int>> scanPositions(const std::vector<std::string>& strings, const std::string& motif) {
+    std::vector<std::pair<int, int>> positions;
+    for (size_t s = 0; s < strings.size(); s++) {
+        for (size_t c = 0; c + motif.size() <= strings[s].size(); c++) {
+            size_t i = 0;
+            while (i < motif.size() && expandchar[motif[i]].find(strings[s][c + i]) != std::string::npos)
+                i++;
+            if (i == motif.size())
+                positions.push_back({(int)s, (int)c});
+        }
+    }
+    return positions;
+}
+
+// alignment based: the best occurence of the species that have the motif in the same column of the same strand
+occurence_bits scanBestOccurence(const std::vector<std::pair<int, int>>& positions, const BLSScore& bls) {
+    std::map<std::pair<int, int>, occurence_bits> columns; // <strand, column>
+    for (const auto& p : positions)
+        columns[{p.first & 1, p.second}] |= 1 << (p.first / 2);
+    occurence_bits best = 0;
+    for (const auto& column : columns) {
+        if (__builtin_popcount(column.second) > 1 && bls.getBLSScore(column.second) > bls.getBLSScore(best))
+            best = column.second;
+    }
+    return best;
+}
+
+// the alignment based motifs of the tree with one twofold or N letter, every window of the strings with at most one of its letters
+// made degenerate is written iff its scanned best column scores, with the bls vector of that column
+void checkAlignmentBasedDegenerate(SuffixTree& tree, const std::vector<std::string>& strings, const BLSScore& bls, std::map<std::string, int>& written) {
+    SuffixTreeTestAccess::writeText(tree);
+    std::pair<short, short> lengths(6, 9); // the positions of the shorter motifs are collected from their extensions
+    std::ostringstream out;
+    ASSERT_GT(tree.printMotifs(lengths, TWOFOLDSANDN, 1, bls, out, true), 0);
+    std::istringstream lines(out.str());
+    std::string group, motif;
+    int blsVector;
+    while (lines >> group >> motif >> blsVector)
+        written[motif] = blsVector;
+
+    std::set<std::string> candidates;
+    for (const std::string& string : strings) {
+        for (size_t c = 0; c < string.size(); c++) {
+            for (short length = lengths.first; length < lengths.second && c + length <= string.size(); length++) {
+                std::string window = string.substr(c, length);
+                if (window.find(IupacMask::DELIMITER) != std::string::npos)
+                    break;
+                candidates.insert(window);
+                for (size_t i = 0; i < window.size(); i++) {
+                    for (char letter : twofoldandN) {
+                        std::string degenerate = window;
+                        degenerate[i] = letter;
+                        if (expandchar[letter].find(window[i]) != std::string::npos)
+                            candidates.insert(degenerate);
+                    }
+                }
+            }
+        }
+    }
+    size_t expected = 0;
+    for (const std::string& candidate : candidates) {
+        occurence_bits best = scanBestOccurence(scanPositions(strings, candidate), bls);
+        bool isWritten = Motif::isGroupRepresentative(candidate) && bls.greaterThanMinThreshold(best);
+        ASSERT_EQ(written.count(candidate), isWritten) << candidate;
+        if (isWritten) {
+            ASSERT_EQ(written[candidate], bls.getBLSVector(best)[0]) << candidate;
+            expected++;
+        }
+    }
+    ASSERT_EQ(written.size(), expected);
+}
+
+TEST_F (MotifIteratorTest, AlignmentBasedDegenerate) { // the motifs and scores of the alignment based recursion match a scan of the strings
+    std::vector<std::string> strings = splitStrings(T, stringStartPositions);
+    ASSERT_EQ(strings.size(), 8);
+    std::map<std::string, int> written; // motif -> bls vector
+    checkAlignmentBasedDegenerate(*ST, strings, *bls, written);
+    ASSERT_FALSE(HasFatalFailure());
+
+    // a few motifs by hand: <string, column> as the tree finds them and the bls vector of their best column
+    // GYACGTAC is in column 1 of the reverse complements of BD and OS, the other occurrences are alone in their column
+    std::vector<std::tuple<std::string, std::vector<std::pair<int, int>>, int>> known{
+        {"ACGTACGT", {{0, 3}, {1, 3}, {2, 3}, {3, 3}, {4, 3}, {5, 3}, {6, 3}, {7, 3}}, 6},
+        {"CTACGYAC", {{2, 1}, {4, 1}, {7, 1}}, 3},
+        {"GNACGTAC", {{0, 5}, {1, 1}, {3, 1}, {5, 1}, {6, 1}, {7, 5}}, 5},
+        {"GYACGTAC", {{0, 5}, {1, 1}, {3, 1}, {6, 1}, {7, 5}}, 2}};
+    for (const auto& motif : known) {
+        const std::string& iupac = std::get<0>(motif);
+        occurence_bits occurence = 0;
+        std::vector<std::pair<int, int>> positions = ST->matchIupacPattern(iupac, *bls, 1, occurence);
+        std::sort(positions.begin(), positions.end());
+        ASSERT_EQ(positions, std::get<1>(motif)) << iupac;
+        ASSERT_EQ(written[iupac], std::get<2>(motif)) << iupac;
+    }
+}
+
+TEST_F (MotifIteratorTest, BestOccurenceReusedBuffers) { // the column accumulator is empty again after every call
+    std::vector<std::string> strings = splitStrings(T, stringStartPositions);
+    // <string, column>: ACGTACGT is in column 3 of every string, so that column has forward and reverse complement hits
+    std::vector<std::vector<std::pair<int, int>>> calls{
+        {{0, 3}, {1, 3}, {2, 3}, {3, 3}, {4, 3}, {5, 3}, {6, 3}, {7, 3}, {0, 5}, {2, 5}},
+        {{0, 3}, {3, 3}, {4, 5}},                  // the same columns, but no strand of them is conserved any more
+        {{2, 3}, {4, 3}, {5, 3}, {6, 5}, {7, 5}}};
+    LocationBuffers buffers;
+    for (const auto& call : calls) {
+        std::vector<size_t> positions{0, stringStartPositions[6]}; // skipped, they are before start
+        for (const auto& p : call)
+            positions.push_back(stringStartPositions[p.first] + p.second);
+        occurence_bits occurence = 0, fresh = 0;
+        SuffixTreeTestAccess::getBestOccurence(*ST, positions, 2, *bls, occurence, buffers);
+        for (size_t c = 0; c < buffers.columnOcc.size(); c++) {
+            ASSERT_EQ(buffers.columnOcc[c], 0) << c;
+            ASSERT_EQ(buffers.columnRcOcc[c], 0) << c;
+        }
+        LocationBuffers freshBuffers;
+        SuffixTreeTestAccess::getBestOccurence(*ST, positions, 2, *bls, fresh, freshBuffers);
+        ASSERT_EQ(occurence, fresh);
+        ASSERT_EQ(occurence, scanBestOccurence(call, *bls));
+    }
+}
+
+TEST_F (MotifIteratorTest, StringPositions) { // every position of T lies in the string that starts at or before it
+    std::vector<std::string> strings = splitStrings(T, stringStartPositions);
+    ASSERT_EQ(stringStartPositions.back(), T.size()); // the last string ends with both delimiters of T
+    for (size_t s = 0; s + 1 < stringStartPositions.size(); s++) {
+        for (size_t p = stringStartPositions[s]; p < stringStartPositions[s + 1]; p++) { // with the delimiters after the string
+            std::pair<int, int> position = SuffixTreeTestAccess::getStringPosition(*ST, p);
+            ASSERT_EQ(position, (std::pair<int, int>(s, p - stringStartPositions[s]))) << p;
+            if (position.second < strings[s].size())
+                ASSERT_EQ(T[p], strings[s][position.second]) << p;
+        }
+    }
+}
+
+template<typename T>
+T readBinary(std::istream& in) {
+    T value;
+    in.read((char*)&value, sizeof(T));
+    return value;
+}
+
+TEST_F (MotifIteratorTest, LocateMotifsBinary) { // the binary positions decode to the text output
+    std::string motifs = "ACGTACGT\t0\nACGTNCGT\t0\nCGTACGTA\t0\nCTACGTAC\t0\nGTACGTAG\t0\n\n";
+    std::istringstream textIn(motifs), binaryIn(motifs);
+    MotifTrie textTrie, binaryTrie;
+    textTrie.readMotifs(textIn);
+    binaryTrie.readMotifs(binaryIn);
+    std::ostringstream textOut;
+    ST->matchMotifTrie(textTrie, textOut, *bls, 1, 0.0f, false);
+    std::stringstream binaryOut; // as in location mode: the gene table, the motif records and a motif of length 0
+    ST->writeGeneTable(binaryOut);
+    ST->matchMotifTrie(binaryTrie, binaryOut, *bls, 1, 0.0f, true);
+    binaryOut.put(0);
+
+    std::string family(readBinary<uint32_t>(binaryOut), ' ');
+    binaryOut.read(&family[0], family.size());
+    ASSERT_EQ(family, name);
+    std::vector<std::string> genes(readBinary<uint32_t>(binaryOut));
+    ASSERT_EQ(genes.size(), gene_names.size());
+    for (std::string& gene : genes) {
+        gene.resize(readBinary<uint32_t>(binaryOut));
+        binaryOut.read(&gene[0], gene.size());
+    }
+    ASSERT_EQ(genes, gene_names);
+    std::ostringstream decoded; // the text format, the score as written by an ostream
+    size_t records = 0;
+    for (int length = binaryOut.get(); length > 0; length = binaryOut.get(), records++) {
+        std::string motif(length, ' ');
+        binaryOut.read(&motif[0], length);
+        decoded << motif << '\t' << readBinary<float>(binaryOut) << '\t';
+        uint32_t count = readBinary<uint32_t>(binaryOut);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t gene = readBinary<uint32_t>(binaryOut);
+            uint32_t position = readBinary<uint32_t>(binaryOut);
+            ASSERT_LT(gene >> 1, genes.size());
+            decoded << (i > 0 ? ";" : "") << genes[gene >> 1] << ((gene & 1) ? "@-" : "@+") << position;
+        }
+        decoded << '\n';
+    }
+    ASSERT_TRUE(binaryOut.good());
+    ASSERT_EQ(binaryOut.peek(), EOF); // nothing follows the end of the family
+    ASSERT_EQ(records, 5);
+    ASSERT_EQ(decoded.str(), textOut.str());
+    // OS and ZM on the reverse complement, SB on the forward strand: the score and the strands of the text output
+    ASSERT_NE(textOut.str().find("GTACGTAG\t0.7312\tOS@-5;ZM@-5;SB@+5\n"), std::string::npos);
+}
+
+TEST (MotifMap, SnapshotRoundTrip) { // a restored map counts on with the same bls vectors as the map it was written from
+    std::pair<short, short> l(8, 9);
+    const char blsvectorsize = 6;
+    const std::string iupac = "ACGTRYSWKMBDHVN";
+    std::vector<std::string> motifs;
+    unsigned int seed = 1;
+    for (int i = 0; i < 2000; i++) {
+        std::string motif;
+        for (int j = 0; j < l.first; j++) {
+            seed = seed * 1103515245 + 12345;
+            motif.push_back(iupac[(seed >> 16) % (j < 4 ? 4 : iupac.size())]); // shared prefixes, so nodes get several children
+        }
+        motifs.push_back(motif);
+    }
+    MyMotifMap reference(blsvectorsize, l), snapshot(blsvectorsize, l), restored(blsvectorsize, l);
+    for (size_t i = 0; i < motifs.size() / 2; i++) {
+        reference.addMotifToMap(motifs[i], 1 + i % blsvectorsize);
+        snapshot.addMotifToMap(motifs[i], 1 + i % blsvectorsize);
+    }
+    std::stringstream stored;
+    snapshot.write(stored);
+    restored.read(stored);
+    for (size_t i = motifs.size() / 2; i < motifs.size(); i++) {
+        reference.addMotifToMap(motifs[i], 1 + i % blsvectorsize);
+        restored.addMotifToMap(motifs[i], 1 + i % blsvectorsize);
+    }
+    long referenceCount = 0, restoredCount = 0;
+    std::ostringstream referenceOut, restoredOut;
+    reference.recPrintAndDelete(referenceCount, referenceOut);
+    restored.recPrintAndDelete(restoredCount, restoredOut);
+    ASSERT_GT(referenceCount, 0);
+    ASSERT_EQ(referenceCount, restoredCount);
+    ASSERT_EQ(referenceOut.str(), restoredOut.str());
+}
+
+TEST_F (MotifIteratorTest, TreeIndexRoundTrip) { // a mapped tree locates the same motifs as the tree it was written from
+    std::string filename = ::testing::TempDir() + "motifiteratortests.idx";
+    {
+        std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+        TreeIndex::writeHeader(out);
+        TreeIndex::write(out, *ST);
+    }
+    TreeIndex index(filename);
+    ASSERT_TRUE(index.isOpen());
+    ASSERT_EQ(index.familyCount(), 1);
+    std::unique_ptr<SuffixTree> mapped(index.map(name, T, order_of_species_mapping, gene_names));
+    ASSERT_TRUE(mapped != NULL);
+    std::string queries = "ACGTACGT\t0\nACGTACG\t0\nACGTNCGT\t0\nCGTACGTA\t0\nTACGTAGT\t0\nGCTACG\t0\nRCGTAC\t0\nTTTTTT\t0\n\n";
+    std::istringstream builtIn(queries), mappedIn(queries);
+    std::ostringstream builtOut, mappedOut;
+    ASSERT_EQ(ST->matchIupacPatterns(builtIn, builtOut, *bls, 1, 0.0f), mapped->matchIupacPatterns(mappedIn, mappedOut, *bls, 1, 0.0f));
+    ASSERT_FALSE(builtOut.str().empty());
+    ASSERT_EQ(builtOut.str(), mappedOut.str());
+    ASSERT_EQ(ST->getNodeCount(), mapped->getNodeCount());
+
+    // the index is not used for the same text read with another species tree or other genes
+    std::vector<size_t> otherSpecies(order_of_species_mapping.rbegin(), order_of_species_mapping.rend());
+    ASSERT_TRUE(index.map(name, T, otherSpecies, gene_names) == NULL);
+    std::vector<std::string> otherGenes(gene_names);
+    otherGenes[0] += "_other";
+    ASSERT_TRUE(index.map(name, T, order_of_species_mapping, otherGenes) == NULL);
+    ASSERT_TRUE(index.map(name, T.substr(1), order_of_species_mapping, gene_names) == NULL);
+    ASSERT_TRUE(index.map("OTHER", T, order_of_species_mapping, gene_names) == NULL);
+    std::remove(filename.c_str());
+}
+
+// the family of MotifIteratorTest with low complexity runs and tandem repeats in the genes
+class RepetitiveFamilyTest: public MotifIteratorTest {
+protected:
+    RepetitiveFamilyTest() {
+        std::string run(500, 'N'), tandem;
+        for (int i = 0; i < 150; i++)
+            tandem += "ACG";
+        orthogroup[4] = BD + run + tandem + BD;
+        orthogroup[6] = OS + tandem + "T" + tandem;
+        orthogroup[8] = ZM + std::string(40, 'A') + ZM;
+        orthogroup[10] = SB + run + SB;
+    }
+};
+
+TEST_F (RepetitiveFamilyTest, PartitionedConstruction) { // the partitioned tree finds the same motifs and positions as Ukkonen's
+    for (int threads = 2; threads <= 4; threads += 2) {
+        SuffixTree partitioned(T, name, true, stringStartPositions, gene_names, next_gene_locations, order_of_species_mapping, NULL, threads);
+        ASSERT_EQ(ST->getNodeCount(), partitioned.getNodeCount());
+        for (int type = 0; type < 2; type++) { // 0 == AB, 1 is AF
+            std::ostringstream ukonenOut, partitionedOut;
+            int count = ST->printMotifs(l, (Alphabet)2, 1, *bls, ukonenOut, type == 0);
+            ASSERT_GT(count, 0);
+            ASSERT_EQ(count, partitioned.printMotifs(l, (Alphabet)2, 1, *bls, partitionedOut, type == 0));
+            ASSERT_EQ(ukonenOut.str(), partitionedOut.str());
+        }
+        std::string queries = "ACGACGACG\t0\nACGTACGT\t0\nNNNNNNNN\t0\nAAAAAA\t0\nACGNACG\t0\nCGTNCG\t0\nGTACGTAG\t0\n\n";
+        std::istringstream ukonenIn(queries), partitionedIn(queries);
+        std::ostringstream ukonenOut, partitionedOut;
+        ASSERT_EQ(ST->matchIupacPatterns(ukonenIn, ukonenOut, *bls, 1, 0.0f), partitioned.matchIupacPatterns(partitionedIn, partitionedOut, *bls, 1, 0.0f));
+        ASSERT_FALSE(ukonenOut.str().empty());
+        ASSERT_EQ(ukonenOut.str(), partitionedOut.str());
+    }
+}
+
+TEST (AlignmentBased, LastReverseComplement) { // every suffix of the last reverse complement has a leaf, also if it repeats the end of another string
+    std::vector<float> blsThresholds{0.15, 0.5, 0.6, 0.7, 0.9, 0.95};
+    // BD and SB, the last gene, start with TGCAACGT, so their reverse complements both end with ACGTTGCA in column 6
+    std::istringstream in(orthoGroupInput("LASTRC", {"TGCAACGTGGATCC", "TTTTCCCCAAAAGG", "GGGGAAAACCCCTT", "TGCAACGTCCTAGG"}));
+    OrthoFamily family;
+    ASSERT_TRUE(GeneFamily::readFamily(in, blsThresholds, family));
+    std::unique_ptr<SuffixTree> tree(buildTree(family));
+    occurence_bits occurence = 0;
+    std::vector<std::pair<int, int>> positions = tree->matchIupacPattern("ACGTTGCA", *family.bls, 0, occurence);
+    std::sort(positions.begin(), positions.end());
+    // <string, column>: the reverse complement of SB was missing when T ended with a single delimiter
+    ASSERT_EQ(positions, (std::vector<std::pair<int, int>>{{1, 6}, {7, 6}}));
+
+    // alignment based, the motif is conserved in column 6 of both reverse complements, without SB it was not written
+    SuffixTreeTestAccess::writeText(*tree);
+    std::ostringstream out;
+    tree->printMotifs(std::pair<short, short>(8, 9), EXACT, 0, *family.bls, out, true);
+    std::string line = "\tACGTTGCA\t";
+    size_t found = out.str().find(line);
+    ASSERT_NE(found, std::string::npos);
+    const occurence_bits BDAndSB = 1 | (1 << 3); // species bits in the order of the strings
+    ASSERT_EQ(std::stoi(out.str().substr(found + line.size())), family.bls->getBLSVector(BDAndSB)[0]);
+}
+
+TEST (AlignmentBased, FillersDegenerate) { // the positions of a prefix continued by a filler count in its column
+    std::vector<float> blsThresholds{0.15, 0.5, 0.6, 0.7, 0.9, 0.95};
+    std::istringstream in(orthoGroupInput("FILLERS", {"ACGTTGCA-TTACGTTGCAGGCACGTTGCA-AACGTTGCA", "ACGTTGCAGTTACGTTGCA-GCACGTTGCATAACGTTGC-",
+        "ACGTTGC--TTACGTTGCAT-CACGTTGCA-AACGTTGCA", "ACGTTGCA-TTACGTTGCA-GCACGTTGCAGAACGTTGCT"}));
+    OrthoFamily family;
+    ASSERT_TRUE(GeneFamily::readFamily(in, blsThresholds, family));
+    std::unique_ptr<SuffixTree> tree(buildTree(family));
+    std::vector<std::string> strings = splitStrings(family.T, family.stringStartPositions);
+    ASSERT_EQ(strings.size(), 8);
+    std::map<std::string, int> written;
+    checkAlignmentBasedDegenerate(*tree, strings, *family.bls, written);
+    ASSERT_FALSE(HasFatalFailure());
+
+    // <string, column> and the bls vector of the best column, a filler follows ACGTTGCA in BD at columns 0, 11 and 22
+    // and CAACGTGC in the reverse complement of BD at column 12, CAACGTKC also matches the reverse complement of SB alone at column 2
+    std::vector<std::tuple<std::string, std::vector<std::pair<int, int>>, int>> known{
+        {"ACGTTGCA", {{0, 0}, {0, 11}, {0, 22}, {0, 32}, {2, 0}, {2, 11}, {2, 22}, {4, 11}, {4, 22}, {4, 32}, {6, 0}, {6, 11}, {6, 22}}, 6},
+        {"CAACGTGC", {{1, 12}, {3, 12}, {7, 12}}, 5},
+        {"CAACGTKC", {{1, 12}, {3, 12}, {7, 2}, {7, 12}}, 5}};
+    for (const auto& motif : known) {
+        const std::string& iupac = std::get<0>(motif);
+        occurence_bits occurence = 0;
+        std::vector<std::pair<int, int>> positions = tree->matchIupacPattern(iupac, *family.bls, 1, occurence);
+        std::sort(positions.begin(), positions.end());
+        ASSERT_EQ(positions, std::get<1>(motif)) << iupac;
+        ASSERT_EQ(written[iupac], std::get<2>(motif)) << iupac;
+    }
+}
+
+TEST (ForwardStrand, SameMotifsAsBothStrands) { // the forward strand index adds the reverse complement of every motif
+    std::vector<float> blsThresholds{0.15, 0.5, 0.6, 0.7, 0.9, 0.95};
+    std::pair<short, short> l(5, 9);
+    for (int maxDegenerateLetters = 0; maxDegenerateLetters <= 2; maxDegenerateLetters++) {
+        for (int alphabet = maxDegenerateLetters == 0 ? 0 : 1; alphabet <= 3; alphabet++) { // the exact alphabet has no degenerate letters
+            std::istringstream bothIn(repetitiveOrthoGroupInput()), forwardIn(repetitiveOrthoGroupInput());
+            OrthoFamily both, forward;
+            ASSERT_TRUE(GeneFamily::readFamily(bothIn, blsThresholds, both));
+            ASSERT_TRUE(GeneFamily::readFamily(forwardIn, blsThresholds, forward, true));
+            ASSERT_EQ(forward.T.size() * 2 - 1, both.T.size());
+            std::unique_ptr<SuffixTree> bothTree(buildTree(both)), forwardTree(buildTree(forward));
+            std::ostringstream bothOut, forwardOut;
+            int count = bothTree->printMotifs(l, (Alphabet)alphabet, maxDegenerateLetters, *both.bls, bothOut, false);
+            ASSERT_GT(count, 0);
+            ASSERT_EQ(count, forwardTree->printMotifs(l, (Alphabet)alphabet, maxDegenerateLetters, *forward.bls, forwardOut, false));
+            ASSERT_EQ(bothOut.str(), forwardOut.str());
+        }
+    }
+}
+
+TEST (KmerTable, SameMotifsAsSuffixTree) { // the k-mer engine enumerates the motifs of the alignment free suffix tree
+    std::vector<float> blsThresholds{0.15, 0.5, 0.6, 0.7, 0.9, 0.95};
+    std::vector<std::string> inputs{repetitiveOrthoGroupInput(), orthoGroupInput("SPARSE_N", {"ACGTNACGTTGCANNGCATACGTT", "TTACGNTGCATGCAACGT",
+        "GCATGCANNNNACGTTGCA", "ACGTTGCANACGTTGCATT"})};
+    KmerTable table(8);
+    for (const std::string& input : inputs) {
+        for (int strands = 0; strands < 2; strands++) {
+            for (int maxDegenerateLetters = 0; maxDegenerateLetters <= 2; maxDegenerateLetters++) {
+                for (int alphabet = maxDegenerateLetters == 0 ? 0 : 1; alphabet <= 3; alphabet++) { // the exact alphabet has no degenerate letters
+                    for (int countBls = 0; countBls < 2; countBls++) {
+                        std::pair<short, short> l(countBls ? 8 : 6, 9); // the motif map holds motifs of one length
+                        std::istringstream in(input);
+                        OrthoFamily family;
+                        ASSERT_TRUE(GeneFamily::readFamily(in, blsThresholds, family, strands == 1));
+                        MyMotifMap treeMap(blsThresholds.size(), l), tableMap(blsThresholds.size(), l);
+                        std::unique_ptr<SuffixTree> tree(new SuffixTree(family.T, family.name, family.hasReverseComplement, family.stringStartPositions,
+                            family.gene_names, family.next_gene_locations, family.order_of_species_mapping, countBls ? &treeMap : NULL));
+                        table.build(family.T, family.hasReverseComplement, family.stringStartPositions, family.order_of_species_mapping);
+                        std::ostringstream treeOut, tableOut;
+                        int count = tree->printMotifs(l, (Alphabet)alphabet, maxDegenerateLetters, *family.bls, treeOut, false);
+                        ASSERT_GT(count, 0);
+                        ASSERT_EQ(count, table.printMotifs(l, (Alphabet)alphabet, maxDegenerateLetters, *family.bls, countBls ? &tableMap : NULL, tableOut));
+                        if (countBls) {
+                            long treeCount = 0, tableCount = 0;
+                            treeMap.recPrintAndDelete(treeCount, treeOut);
+                            tableMap.recPrintAndDelete(tableCount, tableOut);
+                            ASSERT_GT(treeCount, 0);
+                            ASSERT_EQ(treeCount, tableCount);
+                        }
+                        ASSERT_EQ(treeOut.str(), tableOut.str());
+                    }
+                }
+            }
+        }
+    }
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
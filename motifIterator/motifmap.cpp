@@ -23,7 +23,7 @@ void MotifMap::recPrintAndDelete(const std::string currentmotif, long &unique_co
         Motif::writeGroupIDAndMotifInBinary(currentmotif, maxlen, out);
         out.write(&blsvectorsize, 1); // assume
         for(int i = 0; i < blsvectorsize; i++) {
-            std::cout.write((char*)&v[i], sizeof(blscounttype));
+            out.write((char*)&v[i], sizeof(blscounttype));
         }
         delete v;
         unique_count++;
@@ -119,7 +119,7 @@ void SparseMotifMapNode::recPrintAndDelete(const std::string currentmotif, long
             Motif::writeGroupIDAndMotifInBinary(currentmotif, range.second, out);
             out.write(&blsvectorsize, 1); // assume
             for(int i = 0; i < blsvectorsize; i++) {
-                std::cout.write((char*)&v[i], sizeof(blscounttype));
+                out.write((char*)&v[i], sizeof(blscounttype));
             }
             unique_count++;
         }
@@ -143,6 +143,37 @@ void SparseMotifMapNode::recPrintAndDelete(const std::string currentmotif, long
     }
 }
 
+void SparseMotifMapNode::write(std::ostream &out, const size_t pos, const std::pair<int, int> &startIndexes, const std::pair<short, short> &range, const char &blsvectorsize) const {
+    char *iupac_mapping = (char *)&data[0];
+    out.write((char *)data, startIndexes.second * sizeof(SparseMotifMapNode)); // iupac map and bls vector
+    for (int i = 0; i < iupac_mapping[0]; i++) { // children in the order they were added
+        if (pos + 3 < (size_t)range.second) {
+            data[startIndexes.second + i].write(out, pos + 1, startIndexes, range, blsvectorsize);
+        } else {
+            ((MotifMapLeafs *)&data[startIndexes.second + i])->write(out, blsvectorsize);
+        }
+    }
+}
+
+void SparseMotifMapNode::read(std::istream &in, const size_t pos, const std::pair<int, int> &startIndexes, const std::pair<short, short> &range, const char &blsvectorsize) {
+    std::vector<char> header(startIndexes.second * sizeof(SparseMotifMapNode));
+    in.read(header.data(), header.size());
+    int children = header[0];
+    free(data);
+    // at least as large as init and addChild make it, the children pointers start as NULL
+    size_t size = std::max((startIndexes.second + children) * sizeof(SparseMotifMapNode), startIndexes.second * sizeof(SparseMotifMap));
+    data = (SparseMotifMapNode *)malloc(size);
+    memset(static_cast<void *>(data), 0, size);
+    memcpy(static_cast<void *>(data), header.data(), header.size());
+    for (int i = 0; i < children; i++) {
+        if (pos + 3 < (size_t)range.second) {
+            data[startIndexes.second + i].read(in, pos + 1, startIndexes, range, blsvectorsize);
+        } else {
+            ((MotifMapLeafs *)&data[startIndexes.second + i])->read(in, blsvectorsize);
+        }
+    }
+}
+
 // MOTIFMAPLEAFS
 void MotifMapLeafs::init() {
     data = (char *)malloc(1 + IUPAC_FULL_COUNT);
@@ -185,7 +216,7 @@ void MotifMapLeafs::printMotifsAndDeleteData(const std::string currentmotif, lon
             Motif::writeGroupIDAndMotifInBinary(currentmotif + IupacMask::representation[i + 1], range.second, out);
             out.write(&blsvectorsize, 1); // assume less than 256
             for(int i = 0; i < blsvectorsize; i++) {
-                std::cout.write((char*)&v[i], sizeof(blscounttype));
+                out.write((char*)&v[i], sizeof(blscounttype));
             }
             unique_count++;
      //       if(unique_count % 1000000 == 0) {
@@ -196,6 +227,20 @@ void MotifMapLeafs::printMotifsAndDeleteData(const std::string currentmotif, lon
     free(data);
 }
 
+void MotifMapLeafs::write(std::ostream &out, const char &blsvectorsize) const {
+    out.write(data, 1 + IUPAC_FULL_COUNT + blsvectorsize*sizeof(blscounttype)*data[0]);
+}
+
+void MotifMapLeafs::read(std::istream &in, const char &blsvectorsize) {
+    char header[1 + IUPAC_FULL_COUNT];
+    in.read(header, sizeof(header));
+    size_t size = sizeof(header) + blsvectorsize*sizeof(blscounttype)*header[0];
+    free(data);
+    data = (char *)malloc(size);
+    memcpy(data, header, sizeof(header));
+    in.read(&data[sizeof(header)], size - sizeof(header));
+}
+
 // SPARSEMOTIFMAP
 SparseMotifMap::SparseMotifMap(const char &blsvectorsize, const std::pair<short, short> &range) : root(NULL), blsvectorsize(blsvectorsize),
 startIndexes(std::pair<int,int>(
@@ -213,3 +258,9 @@ void SparseMotifMap::recPrintAndDelete(long &unique_count, std::ostream &out) {
     // delete root;
     malloc_trim(0); // this gives memory back to OS!
 };
+void SparseMotifMap::write(std::ostream &out) const {
+    root->write(out, 0, startIndexes, range, blsvectorsize);
+}
+void SparseMotifMap::read(std::istream &in) {
+    root->read(in, 0, startIndexes, range, blsvectorsize);
+}
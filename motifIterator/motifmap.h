@@ -41,6 +41,9 @@ public:
   SparseMotifMapNode(const int &startIndex);
   void addMotifToMap(const std::string &motif, const size_t pos, const int &val, const std::pair<int, int> &startIndexes, const std::pair<short, short> &range, const char &blsvectorsize);
   void recPrintAndDelete(const std::string currentmotif, long &unique_count, std::ostream &out, const std::pair<int, int> &startIndexes, const std::pair<short, short> &range, const char &blsvectorsize);
+  // snapshot of this node and its children (depth first), read replaces the data of this node
+  void write(std::ostream &out, const size_t pos, const std::pair<int, int> &startIndexes, const std::pair<short, short> &range, const char &blsvectorsize) const;
+  void read(std::istream &in, const size_t pos, const std::pair<int, int> &startIndexes, const std::pair<short, short> &range, const char &blsvectorsize);
 };
 // create another class that also has its own bls vector! for if range allows multiple lengths!
 class MotifMapLeafs {
@@ -59,6 +62,8 @@ public:
   MotifMapLeafs() : data(NULL) { init(); };
   void addToBlsVector(const int& iupac_value, const int& val, const char &blsvectorsize);
   void printMotifsAndDeleteData(const std::string currentmotif, long &unique_count, std::ostream &out, const std::pair<short, short> &range, const char &blsvectorsize);
+  void write(std::ostream &out, const char &blsvectorsize) const;
+  void read(std::istream &in, const char &blsvectorsize);
 };
 
 class SparseMotifMap { // second version, less memory usage
@@ -71,5 +76,10 @@ public:
   SparseMotifMap(const char &blsvectorsize, const std::pair<short, short> &range);
   void addMotifToMap(const std::string &motif, const int &val);
   void recPrintAndDelete(long &unique_count, std::ostream &out);
+  /**
+   * Writes the raw nodes of the map so a checkpoint can restore it, only valid for the same build and range
+   */
+  void write(std::ostream &out) const;
+  void read(std::istream &in);
 };
 #endif
@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+#include "benchaccess.h"
+
+// group representatives of length 8, the way the counting mode adds them to the map
+static std::vector<std::string> representatives(const size_t count) {
+    GeneratorConfig config;
+    SyntheticGenerator generator(config);
+    std::vector<std::string> motifs;
+    while (motifs.size() < count) {
+        std::string motif = generator.randomMotif(8, 3);
+        if (Motif::isGroupRepresentative(motif)) motifs.push_back(motif);
+    }
+    return motifs;
+}
+
+static void BM_SparseMotifMapInsert(benchmark::State& state) {
+    std::vector<std::string> motifs = representatives(state.range(0));
+    std::ostringstream out;
+    long unique_count = 0;
+    for (auto _ : state) {
+        MyMotifMap map((char)SuffixTreeBenchmark::blsThresholds().size(), std::make_pair<short, short>(8, 9));
+        for (size_t i = 0; i < motifs.size(); i++) {
+            map.addMotifToMap(motifs[i], i % SuffixTreeBenchmark::blsThresholds().size() + 1);
+        }
+        state.PauseTiming();
+        out.str("");
+        map.recPrintAndDelete(unique_count, out);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * motifs.size());
+}
+BENCHMARK(BM_SparseMotifMapInsert)->RangeMultiplier(8)->Range(1 << 10, 1 << 19)->Unit(benchmark::kMillisecond);
+
+static void BM_SparseMotifMapDrain(benchmark::State& state) {
+    std::vector<std::string> motifs = representatives(state.range(0));
+    std::ostringstream out;
+    long unique_count = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        MyMotifMap map((char)SuffixTreeBenchmark::blsThresholds().size(), std::make_pair<short, short>(8, 9));
+        for (size_t i = 0; i < motifs.size(); i++) {
+            map.addMotifToMap(motifs[i], i % SuffixTreeBenchmark::blsThresholds().size() + 1);
+        }
+        out.str("");
+        state.ResumeTiming();
+        map.recPrintAndDelete(unique_count, out);
+    }
+    state.SetItemsProcessed(state.iterations() * motifs.size());
+}
+BENCHMARK(BM_SparseMotifMapDrain)->RangeMultiplier(8)->Range(1 << 10, 1 << 19)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
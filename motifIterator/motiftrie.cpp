@@ -0,0 +1,63 @@
+#include <algorithm>
+#include "motiftrie.h"
+
+void MotifTrie::readQueries(std::istream& in, std::vector<MotifQuery>& queries) {
+    std::string line;
+    size_t tabIdx;
+    std::getline(in, line);
+    while (!line.empty()) { // loop over motifs until empty line
+        tabIdx = line.find_first_of('\t');
+        queries.push_back({line.substr(0, tabIdx), std::stoi(line.substr(tabIdx + 1))});
+        std::getline(in, line);
+    }
+}
+
+size_t MotifTrie::readMotifs(std::istream& in) {
+    readQueries(in, queries);
+    build();
+    return queries.size();
+}
+
+void MotifTrie::sortQueries(std::vector<MotifQuery>& queries) {
+    std::stable_sort(queries.begin(), queries.end(), [](const MotifQuery& a, const MotifQuery& b) { return a.motif < b.motif; });
+}
+
+void MotifTrie::build() {
+    // sorted queries give the depth first order of the trie, equal motifs keep the order in which they were given
+    sortQueries(queries);
+    nodes.clear();
+    nodes.push_back({IupacMask(), 0, 0, 0, 0});
+    std::vector<uint32_t> path(1, 0); // path[d] is the node of the current prefix of length d
+    const std::string* lastmotif = NULL;
+    for (size_t q = 0; q < queries.size(); q++) {
+        const std::string& motif = queries[q].motif;
+        size_t lcp = 0;
+        if (lastmotif != NULL) {
+            while (lcp < lastmotif->size() && lcp < motif.size() && (*lastmotif)[lcp] == motif[lcp]) {
+                lcp++;
+            }
+        }
+        // close the nodes of the previous motif that are not shared with this one
+        while (path.size() > lcp + 1) {
+            nodes[path.back()].subtreeEnd = nodes.size();
+            path.pop_back();
+        }
+        int degenerateLetters = 0;
+        for (size_t i = 0; i < motif.size(); i++) {
+            if (IupacMask::characterToMask[motif[i]].getCharacters()->size() > 1) degenerateLetters++;
+            if (i < lcp) continue;
+            path.push_back(nodes.size());
+            nodes.push_back({IupacMask::characterToMask[motif[i]], (unsigned char)(i + 1), 0, (uint32_t)q, (uint32_t)q});
+        }
+        MotifTrieNode& last = nodes[path.back()];
+        if (last.firstQuery == last.lastQuery) last.firstQuery = q; // first query that ends in this node
+        last.lastQuery = q + 1;
+        maxDepth = std::max(maxDepth, motif.size());
+        maxDegenerateLetters = std::max(maxDegenerateLetters, degenerateLetters);
+        lastmotif = &motif;
+    }
+    while (!path.empty()) {
+        nodes[path.back()].subtreeEnd = nodes.size();
+        path.pop_back();
+    }
+}
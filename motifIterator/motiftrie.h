@@ -0,0 +1,65 @@
+#ifndef MOTIFTRIE_H
+#define MOTIFTRIE_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "motif.h"
+
+// a motif from the query list with the index of the bls threshold it has to reach
+struct MotifQuery {
+  std::string motif;
+  int blsThresholdIdx;
+};
+
+// A trie node is stored in depth first order, so the children of a node directly follow it and
+// subtreeEnd points to the first node that is not part of its subtree. This means a pruned subtree is skipped with a single jump.
+struct MotifTrieNode {
+  IupacMask mask;           // iupac character on the edge from the parent
+  unsigned char depth;      // length of the prefix ending in this node
+  uint32_t subtreeEnd;      // index of the first node after the subtree of this node
+  uint32_t firstQuery;      // queries ending in this node are [firstQuery, lastQuery[ in the sorted query list
+  uint32_t lastQuery;
+};
+
+/**
+ * Packed trie over a batch of IUPAC query motifs.
+ * The queries are sorted so that every shared prefix is stored (and matched in the suffix tree) only once,
+ * independent of the order in which the motifs are given.
+ */
+class MotifTrie {
+private:
+  std::vector<MotifTrieNode> nodes; // nodes[0] is the root (empty prefix)
+  std::vector<MotifQuery> queries;
+  size_t maxDepth = 0;
+  int maxDegenerateLetters = 0;
+
+public:
+  MotifTrie() {}
+  MotifTrie(std::vector<MotifQuery>::const_iterator first, std::vector<MotifQuery>::const_iterator last) : queries(first, last) { build(); }
+
+  /**
+   * Reads motif lines (motif \t blsThresholdIdx) until an empty line or the end of the stream
+   */
+  static void readQueries(std::istream& in, std::vector<MotifQuery>& queries);
+  /**
+   * Sorts queries in the order in which they are matched and written, a sorted list can be split in blocks that each get their own trie
+   */
+  static void sortQueries(std::vector<MotifQuery>& queries);
+  /**
+   * Reads the motif lines and builds the trie
+   * @return the number of motifs read
+   */
+  size_t readMotifs(std::istream& in);
+  void addMotif(const std::string& motif, const int blsThresholdIdx) { queries.push_back({motif, blsThresholdIdx}); }
+  void build();
+
+  size_t size() const { return nodes.size(); }
+  const MotifTrieNode& getNode(const size_t idx) const { return nodes[idx]; }
+  const MotifQuery& getQuery(const size_t idx) const { return queries[idx]; }
+  size_t getQueryCount() const { return queries.size(); }
+  size_t getMaxDepth() const { return maxDepth; }
+  int getMaxDegenerateLetters() const { return maxDegenerateLetters; }
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include <benchmark/benchmark.h>
+#include "benchaccess.h"
+
+// collects the leaves under every distinct prefix of length depth, deeper prefixes have fewer leaves each
+static void BM_GetOccurrences(benchmark::State& state) {
+    const int depth = state.range(0);
+    GeneratorConfig config;
+    OrthoFamily family;
+    SuffixTreeBenchmark::generateFamily(config, false, family);
+    std::unique_ptr<SuffixTree> tree(SuffixTreeBenchmark::build(family));
+    STPositionsPerLetter positions(depth + 1, depth);
+    SuffixTreeBenchmark::matchAll(*tree, positions, depth);
+    const STPositionVector& list = positions.list[depth];
+    std::vector<size_t> occ;
+    for (auto _ : state) {
+        occ.clear();
+        for (size_t i = 0; i < list.validPositions; i++) {
+            SuffixTreeBenchmark::getOccurrences(*tree, list.list[i], occ);
+        }
+        benchmark::DoNotOptimize(occ.data());
+    }
+    state.SetItemsProcessed(state.iterations() * occ.size());
+    state.counters["positions"] = list.validPositions;
+}
+BENCHMARK(BM_GetOccurrences)->DenseRange(0, 8, 2)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
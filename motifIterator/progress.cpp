@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include "progress.h"
+
+CountingInputBuffer::CountingInputBuffer(std::streambuf* source_, const size_t size) : source(source_), buffer(size), read(0) {
+    setg(buffer.data(), buffer.data(), buffer.data());
+}
+
+int CountingInputBuffer::underflow() {
+    std::streamsize n = source->sgetn(buffer.data(), buffer.size());
+    if (n <= 0)
+        return traits_type::eof();
+    read.fetch_add(n, std::memory_order_relaxed);
+    setg(buffer.data(), buffer.data(), buffer.data() + n);
+    return traits_type::to_int_type(*gptr());
+}
+
+size_t ProgressReporter::remainingBytes(std::istream& in) {
+    std::streambuf* buf = in.rdbuf();
+    std::streampos current = buf->pubseekoff(0, std::ios::cur, std::ios::in);
+    if (current == std::streampos(-1))
+        return 0;
+    std::streampos end = buf->pubseekoff(0, std::ios::end, std::ios::in);
+    buf->pubseekpos(current, std::ios::in);
+    return end == std::streampos(-1) || end < current ? 0 : (size_t)(end - current);
+}
+
+ProgressReporter::ProgressReporter(const int interval_, const CountingInputBuffer& input_, const size_t inputSize_) :
+    interval(interval_), input(input_), inputSize(inputSize_), families(0), motifs(0), consumed(0) {
+    if (interval > 0)
+        thread = std::thread(&ProgressReporter::run, this);
+}
+
+ProgressReporter::~ProgressReporter() {
+    if (!thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    thread.join();
+}
+
+void ProgressReporter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wakeup.wait_for(lock, std::chrono::seconds(interval), [this]() { return stopping; })) {
+        report();
+    }
+}
+
+static std::string formatDuration(double seconds) {
+    char text[32];
+    long s = (long)seconds;
+    snprintf(text, sizeof(text), "%ldh%02ldm%02lds", s / 3600, (s / 60) % 60, s % 60);
+    return text;
+}
+
+void ProgressReporter::report() {
+    double seconds = elapsed.seconds();
+    size_t bytes = consumed.load(std::memory_order_relaxed);
+    const double MB = 1024 * 1024;
+    // the reader and builder threads write to std::cerr as well, the line is formatted apart and written at once
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1);
+    line << "[progress] " << families.load(std::memory_order_relaxed) << " families, " << bytes / MB << "MB";
+    if (inputSize > 0) {
+        line << " of " << inputSize / MB << "MB (" << 100.0 * std::min(1.0, bytes / (double)inputSize) << "%)";
+    }
+    line << ", " << (size_t)(motifs.load(std::memory_order_relaxed) / seconds) << " motifs/s, elapsed " << formatDuration(seconds);
+    if (inputSize > 0 && bytes > 0) {
+        line << ", ETA " << formatDuration(seconds * ((double)inputSize / bytes - 1));
+    }
+    line << '\n';
+    std::cerr << line.str() << std::flush;
+}
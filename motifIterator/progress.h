@@ -0,0 +1,79 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "stats.h"
+
+/**
+ * Input stream buffer that reads another buffer in large chunks and counts the bytes read, the count can be read from any thread
+ */
+class CountingInputBuffer : public std::streambuf {
+private:
+    std::streambuf* source;
+    std::vector<char> buffer;
+    std::atomic<size_t> read;
+protected:
+    int underflow() override;
+public:
+    CountingInputBuffer(std::streambuf* source_, const size_t size = 1 << 16);
+    // bytes read from the source, at most one chunk ahead of what is consumed
+    size_t bytes() const { return read.load(std::memory_order_relaxed); }
+    // bytes consumed by the reader, only valid on the thread that reads
+    size_t consumed() const { return bytes() - (egptr() - gptr()); }
+};
+
+/**
+ * Prints the progress of the run to stderr every interval seconds, from a background thread.
+ * The reader only updates atomic counters when a family is done, so the input consumed is known per family.
+ */
+class ProgressReporter {
+private:
+    const int interval;
+    const CountingInputBuffer& input;
+    const size_t inputSize; // 0 if unknown, e.g. when reading from a pipe
+    std::atomic<size_t> families;
+    std::atomic<size_t> motifs;
+    std::atomic<size_t> consumed; // input consumed up to the last family that was read
+    Stopwatch elapsed;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+    std::thread thread;
+
+    void run();
+    void report();
+public:
+    /**
+     * @param interval_ seconds between reports, no reports (and no thread) if <= 0
+     */
+    ProgressReporter(const int interval_, const CountingInputBuffer& input_, const size_t inputSize_);
+    ~ProgressReporter();
+
+    /**
+     * Called by the thread that reads the input
+     */
+    void familyDone(const size_t familyMotifs) {
+        familyDone(familyMotifs, input.consumed());
+    }
+    /**
+     * For families that are read by another thread
+     * @param inputEnd input consumed up to the end of the family
+     */
+    void familyDone(const size_t familyMotifs, const size_t inputEnd) {
+        families.fetch_add(1, std::memory_order_relaxed);
+        motifs.fetch_add(familyMotifs, std::memory_order_relaxed);
+        consumed.store(inputEnd, std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of bytes left in the stream, 0 if the stream cannot seek
+     */
+    static size_t remainingBytes(std::istream& in);
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+/**
+ * Bounded queue between exactly one producer and one consumer thread, without locks.
+ * push waits while the queue is full and pop waits while it is empty, so a fast stage cannot run ahead of a slow one.
+ */
+template<typename T>
+class SPSCQueue {
+private:
+    std::vector<T> slots;
+    alignas(64) std::atomic<size_t> head; // next slot to pop, only written by the consumer
+    alignas(64) std::atomic<size_t> tail; // next slot to push, only written by the producer
+
+    // waits that start spinning and end sleeping, a stage can wait for a tree that takes seconds to build
+    static void backoff(int& rounds) {
+        if (rounds < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(rounds < 1024 ? 50 : 1000));
+        rounds++;
+    }
+
+public:
+    SPSCQueue(const size_t capacity) : slots(capacity), head(0), tail(0) {}
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    void push(T&& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        int rounds = 0;
+        while (t - head.load(std::memory_order_acquire) == slots.size())
+            backoff(rounds);
+        slots[t % slots.size()] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+    }
+
+    T pop() {
+        size_t h = head.load(std::memory_order_relaxed);
+        int rounds = 0;
+        while (tail.load(std::memory_order_acquire) == h)
+            backoff(rounds);
+        T value = std::move(slots[h % slots.size()]);
+        head.store(h + 1, std::memory_order_release);
+        return value;
+    }
+};
+
+#endif
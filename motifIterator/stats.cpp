@@ -0,0 +1,108 @@
+#include <iostream>
+#include <algorithm>
+#include <sys/resource.h>
+#include "stats.h"
+
+static const char* phaseNames[PHASE_COUNT] = {"parse", "tree_build", "bls_prep", "iteration", "output", "map_drain"};
+static const char* counterNames[COUNTER_COUNT] = {"nodes_visited", "positions_advanced", "motifs_iterated", "motifs_emitted",
+    "bytes_written", "tree_nodes"};
+
+CountingStreamBuffer::CountingStreamBuffer(std::streambuf* target_, const size_t size) : target(target_), buffer(size) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+bool CountingStreamBuffer::flushBuffer() {
+    std::streamsize n = pptr() - pbase();
+    bool ok = target->sputn(pbase(), n) == n;
+    flushed += n;
+    setp(buffer.data(), buffer.data() + buffer.size());
+    return ok;
+}
+
+int CountingStreamBuffer::overflow(int c) {
+    if (!flushBuffer())
+        return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int CountingStreamBuffer::sync() {
+    return (flushBuffer() && target->pubsync() == 0) ? 0 : -1;
+}
+
+static void writeJsonString(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\';
+        if ((unsigned char)c >= 0x20) out << c;
+    }
+    out << '"';
+}
+
+RunStats::RunStats(const std::string& filename) {
+    if (!filename.empty()) {
+        out.open(filename.c_str());
+        if (!out) {
+            std::cerr << "cannot open stats file " << filename << std::endl;
+        }
+    }
+}
+
+void RunStats::writeBody(const FamilyStats& stats) {
+    out << "\"seconds\": {";
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        out << (p > 0 ? ", " : "") << '"' << phaseNames[p] << "\": " << stats.seconds[p];
+    }
+    out << "}, \"counters\": {";
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        out << (c > 0 ? ", " : "") << '"' << counterNames[c] << "\": " << stats.counters[c];
+    }
+    out << '}';
+}
+
+void RunStats::addFamily(const FamilyStats& stats) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        total.seconds[p] += stats.seconds[p];
+    }
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        if (c == COUNTER_TREE_NODES)
+            total.counters[c] = std::max(total.counters[c], stats.counters[c]);
+        else
+            total.counters[c] += stats.counters[c];
+    }
+    total.textLength += stats.textLength;
+    families++;
+    if (!enabled())
+        return;
+    out << "{\"type\": \"family\", \"name\": ";
+    writeJsonString(out, stats.name);
+    out << ", \"species\": " << stats.species << ", \"text_length\": " << stats.textLength << ", ";
+    writeBody(stats);
+    out << "}\n";
+}
+
+void RunStats::addRunTime(const StatsPhase phase, const double seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    total.seconds[phase] += seconds;
+}
+
+void RunStats::addRunCounter(const StatsCounter counter, const size_t value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    total.counters[counter] += value;
+}
+
+void RunStats::writeSummary() {
+    if (!enabled())
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    out << "{\"type\": \"summary\", \"families\": " << families << ", \"text_length\": " << total.textLength
+        << ", \"wall_seconds\": " << wallTime.seconds() << ", \"peak_rss_kb\": " << usage.ru_maxrss << ", ";
+    writeBody(total);
+    out << "}" << std::endl;
+}
@@ -0,0 +1,75 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include <mutex>
+
+enum StatsPhase { PHASE_PARSE, PHASE_TREE_BUILD, PHASE_BLS_PREP, PHASE_ITERATION, PHASE_OUTPUT, PHASE_MAP_DRAIN, PHASE_COUNT };
+enum StatsCounter { COUNTER_NODES_VISITED, COUNTER_POSITIONS_ADVANCED, COUNTER_MOTIFS_ITERATED, COUNTER_MOTIFS_EMITTED,
+    COUNTER_BYTES_WRITTEN, COUNTER_TREE_NODES, COUNTER_COUNT };
+
+// measures the time since it was created or restarted, every thread or phase uses its own
+class Stopwatch {
+private:
+    std::chrono::steady_clock::time_point start;
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {}
+    void restart() { start = std::chrono::steady_clock::now(); }
+    double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+};
+
+// time per phase and counters of one family
+struct FamilyStats {
+    std::string name;
+    int species = 0;
+    size_t textLength = 0;
+    double seconds[PHASE_COUNT] = {};
+    size_t counters[COUNTER_COUNT] = {};
+};
+
+/**
+ * Output stream buffer that forwards everything to another buffer in large chunks and counts the bytes written
+ */
+class CountingStreamBuffer : public std::streambuf {
+private:
+    std::streambuf* target;
+    std::vector<char> buffer;
+    size_t flushed = 0;
+    bool flushBuffer();
+protected:
+    int overflow(int c) override;
+    int sync() override;
+public:
+    CountingStreamBuffer(std::streambuf* target_, const size_t size = 1 << 16);
+    ~CountingStreamBuffer() { sync(); }
+    size_t bytes() const { return flushed + (pptr() - pbase()); }
+};
+
+/**
+ * Writes one json line per family and a summary of the run to the stats file, does nothing if no file is given.
+ * Families can be added from several threads.
+ */
+class RunStats {
+private:
+    std::ofstream out;
+    std::mutex mutex;
+    FamilyStats total; // sum of all families, the tree node count is the maximum
+    size_t families = 0;
+    Stopwatch wallTime;
+
+    void writeBody(const FamilyStats& stats);
+public:
+    RunStats(const std::string& filename);
+
+    bool enabled() const { return out.is_open(); }
+    void addFamily(const FamilyStats& stats);
+    // phases and counters that belong to the whole run, such as draining the motif map
+    void addRunTime(const StatsPhase phase, const double seconds);
+    void addRunCounter(const StatsCounter counter, const size_t value);
+    void writeSummary();
+};
+
+#endif
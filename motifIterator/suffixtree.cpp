@@ -21,6 +21,10 @@
 #include <cassert>
 #include <stack>
 #include <list>
+#include <charconv>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 #include "suffixtree.h"
 #include "motif.h"
 #include "malloc.h"
@@ -67,7 +71,7 @@ bool SuffixTree::advancePos(STPosition& pos, char c) const
         return true;
 }
 
-bool SuffixTree::advancePos(STPosition& pos, const string& P,
+bool SuffixTree::advancePos(STPosition& pos, string_view P,
                             size_t begin, size_t end) const
 {
         for (auto itP = P.begin() + begin; itP < P.begin() + end; itP++)
@@ -77,7 +81,7 @@ bool SuffixTree::advancePos(STPosition& pos, const string& P,
         return true;
 }
 
-void SuffixTree::advancePosSkipCount(STPosition& pos, const std::string& P,
+void SuffixTree::advancePosSkipCount(STPosition& pos, std::string_view P,
                                      size_t begin, size_t end) const
 {
         assert(begin <= end);
@@ -104,13 +108,13 @@ STPosition SuffixTree::followSuffixLink(const STPosition& pos) const
         if (pos.node == root)
                 return pos;
 
-        STNode* parent = pos.node->getParent();
+        STNode* parent = getParent(pos.node);
         if (parent == root) {   // special case for edges originating from the root
                 STPosition newPos(root);
                 advancePosSkipCount(newPos, T, pos.node->begin()+1, pos.node->begin()+pos.offset);
                 return newPos;
         } else {                // generic case (parent is an internal node)
-                STPosition newPos(parent->getSuffixLink());
+                STPosition newPos(getSuffixLink(parent));
                 advancePosSkipCount(newPos, T, pos.node->begin(), pos.node->begin()+pos.offset);
                 return newPos;
         }
@@ -118,27 +122,8 @@ STPosition SuffixTree::followSuffixLink(const STPosition& pos) const
 
 string SuffixTree::posToStr(const STPosition& pos) const
 {
-        string str;
-        str.reserve(pos.getDepth());
-
-        // create a stack with nodes from position (bottom) to root (top)
-        stack<STNode*> path;
-        path.push(pos.node);
-        while (path.top()->getParent() != NULL)
-                path.push(path.top()->getParent());
-
-        path.pop();     // remove root (empty string);
-
-        // traverse the stack from root (top) to position (bottom)
-        while(!path.empty()) {
-                STNode* node = path.top();
-                path.pop();
-
-                size_t len = path.empty() ? pos.offset : node->getEdgeLength();
-                str.append(T.substr(node->begin(), len));
-        }
-
-        return str;
+        // every suffix under the position starts with its string
+        return string(T.substr(leafSuffixes[pos.node->getFirstLeaf()], pos.getDepth()));
 }
 
 // ----------------------------------------------------------------------------
@@ -147,22 +132,8 @@ string SuffixTree::posToStr(const STPosition& pos) const
 
 void SuffixTree::getOccurrences(const STPosition& pos, vector<size_t>& occ) const
 {
-    // if so, find all the leaves under "pos"
-    stack<STNode*> stack;
-    stack.push(pos.node);
-
-    while (!stack.empty()) {
-        // std::cerr << "stack size " << stack.size() << std::endl;
-        STNode* node = stack.top();
-        stack.pop();
-
-        if (node->isLeaf())
-            occ.push_back(node->getSuffixIdx());
-        else
-            for (unsigned char i = 0; i < MAX_CHAR; i++)
-                if (node->getChildNumber(i) != NULL)
-                    stack.push(node->getChildNumber(i));
-    }
+    // all the leaves under "pos" are numbered consecutively
+    occ.insert(occ.end(), leafSuffixes + pos.node->getFirstLeaf(), leafSuffixes + pos.node->getLastLeaf());
 }
 
 void SuffixTree::reportMEM(const string& Q, size_t j, size_t minSize,
@@ -174,10 +145,14 @@ void SuffixTree::reportMEM(const string& Q, size_t j, size_t minSize,
                 if (j == 0 || i == 0 || Q[j-1] != T[i-1]) // left-maximal?
                         occ.push_back(MEMOcc(i, j, pos.getDepth()));
 
-        STNode* node = pos.node->getParent();
-        STNode* last = pos.node;
+        // the nodes from the root to pos spell Q[j, j + depth[, the tree has no parent links
+        vector<STNode*> path(1, root);
+        while (path.back() != pos.node)
+                path.push_back(path.back()->getChild(Q[j + path.back()->getDepth()]));
 
-        while (node->getDepth() >= minSize) {
+        for (size_t k = path.size() - 1; k > 0 && path[k - 1]->getDepth() >= minSize; k--) {
+                STNode* node = path[k - 1];
+                STNode* last = path[k];
                 for (size_t i = 0; i < MAX_CHAR; i++) {
                         STNode* chd = node->getChild(i);
                         if (chd == NULL || chd == last)
@@ -190,9 +165,6 @@ void SuffixTree::reportMEM(const string& Q, size_t j, size_t minSize,
                                 if (i == 0 || j == 0 || Q[j-1] != T[i-1]) // left-maximal?
                                         occ.push_back(MEMOcc(i, j, node->getDepth()));
                 }
-
-                last = node;
-                node = node->getParent();
         }
 }
 
@@ -200,6 +172,40 @@ void SuffixTree::reportMEM(const string& Q, size_t j, size_t minSize,
 // ROUTINES TO MANIPULATE SUFFIX TREE
 // ----------------------------------------------------------------------------
 
+STNode* SuffixTree::newNode(length_t begin, length_t end)
+{
+        // the nodes are used by address while the tree is built
+        if (nodes.size() == nodes.capacity())
+                throw runtime_error("Node block of the suffix tree is full");
+        nodes.emplace_back(begin, end);
+        constructionLinks.emplace_back();
+        node_count++;
+        return &nodes.back();
+}
+
+STNode* SuffixTree::getParent(const STNode* node) const
+{
+        uint32_t parent = constructionLinks[nodeIndex(node)].parent;
+        return parent == STNodeLinks::NONE ? NULL : root + parent; // the root is the first node of the block
+}
+
+STNode* SuffixTree::getSuffixLink(const STNode* node) const
+{
+        uint32_t suffixLink = constructionLinks[nodeIndex(node)].suffixLink;
+        return suffixLink == STNodeLinks::NONE ? NULL : root + suffixLink;
+}
+
+void SuffixTree::setSuffixLink(STNode* node, STNode* target)
+{
+        constructionLinks[nodeIndex(node)].suffixLink = nodeIndex(target);
+}
+
+void SuffixTree::setChild(STNode* node, char c, STNode* chd)
+{
+        node->setChild(c, chd);
+        constructionLinks[nodeIndex(chd)].parent = nodeIndex(node);
+}
+
 STPosition SuffixTree::splitEdge(const STPosition& pos)
 {
         // check whether we are really in the middle of an edge
@@ -207,26 +213,23 @@ STPosition SuffixTree::splitEdge(const STPosition& pos)
                 return pos;
 
         STNode *chd = pos.node;
-        STNode *par = chd->getParent();
-        STNode *mid = new STNode(chd->begin(), chd->begin() + pos.offset);
-        node_count++;
-        mid->setOccurence(chd->getOccurence());
+        STNode *par = getParent(chd);
+        STNode *mid = newNode(chd->begin(), chd->begin() + pos.offset);
         chd->setBegin(mid->end());
 
 
         // set the correct pointers
-        par->setChild(T[mid->begin()], mid);
-        mid->setChild(T[chd->begin()], chd);
+        setChild(par, T[mid->begin()], mid);
+        setChild(mid, T[chd->begin()], chd);
 
         return STPosition(mid);
 }
 
 void SuffixTree::addLeaf(const STPosition& pos, length_t suffixIndex)
 {
-        STNode *leaf = new STNode(suffixIndex + pos.getDepth(), T.size());
-        node_count++;
+        STNode *leaf = newNode(suffixIndex + pos.getDepth(), T.size());
         leaf->setSuffixIdx(suffixIndex);
-        pos.node->setChild(T[suffixIndex + pos.getDepth()], leaf);
+        setChild(pos.node, T[suffixIndex + pos.getDepth()], leaf);
         // std::cerr << "added new leaf:" << suffixIndex + pos.getDepth() << " ";
 }
 void SuffixTree::addLeaf(const STPosition& pos, length_t suffixIndex, unsigned char currentbit)
@@ -236,6 +239,66 @@ void SuffixTree::addLeaf(const STPosition& pos, length_t suffixIndex, unsigned c
         pos.node->getChild(T[suffixIndex + pos.getDepth()])->setOccurenceBitForGST(actual_occurence_bit); // factor 2 means reversecomplement is added in the reference string!
 }
 
+occurence_bits SuffixTree::annotateSubtree(STNode* subtree)
+{
+        if (subtree->isLeaf()) {
+                subtree->setLeafRange(ownLeafSuffixes.size(), ownLeafSuffixes.size() + 1);
+                ownLeafSuffixes.push_back(subtree->getSuffixIdx());
+                return subtree->getOccurence();
+        }
+        // post-order with an explicit stack that holds the union of the children done so far,
+        // the children of a node are prefetched together when it is pushed, the leaves are added right away.
+        // Children are visited from the last to the first, the order in which a stack of the children pops them
+        struct Frame {
+                STNode* node;
+                int next;
+                occurence_bits occurence;
+                length_t firstLeaf;
+        };
+        vector<Frame> stack;
+        stack.push_back({subtree, MAX_CHAR - 1, subtree->getOccurence(), (length_t)ownLeafSuffixes.size()});
+        for (int c = 0; c < MAX_CHAR; c++)
+                if (subtree->getChildNumber(c) != NULL)
+                        __builtin_prefetch(subtree->getChildNumber(c));
+        while (!stack.empty()) {
+                Frame& top = stack.back();
+                STNode* chd = NULL;
+                while (top.next >= 0 && chd == NULL)
+                        chd = top.node->getChildNumber(top.next--);
+                if (chd == NULL) { // all children done
+                        top.node->setOccurence(top.occurence);
+                        top.node->setLeafRange(top.firstLeaf, ownLeafSuffixes.size());
+                        occurence_bits occurence = top.occurence;
+                        stack.pop_back();
+                        if (!stack.empty())
+                                stack.back().occurence |= occurence;
+                } else if (chd->isLeaf()) {
+                        top.occurence |= chd->getOccurence();
+                        chd->setLeafRange(ownLeafSuffixes.size(), ownLeafSuffixes.size() + 1);
+                        ownLeafSuffixes.push_back(chd->getSuffixIdx());
+                } else {
+                        stack.push_back({chd, MAX_CHAR - 1, 0, (length_t)ownLeafSuffixes.size()});
+                        for (int c = 0; c < MAX_CHAR; c++)
+                                if (chd->getChildNumber(c) != NULL)
+                                        __builtin_prefetch(chd->getChildNumber(c));
+                }
+        }
+        return subtree->getOccurence();
+}
+
+void SuffixTree::annotateTree()
+{
+        ownLeafSuffixes.clear();
+        ownLeafSuffixes.reserve(T.size());
+        occurence_bits occurence = 0;
+        for (int c = MAX_CHAR - 1; c >= 0; c--)
+                if (root->getChildNumber(c) != NULL)
+                        occurence |= annotateSubtree(root->getChildNumber(c));
+        root->setOccurence(occurence);
+        root->setLeafRange(0, ownLeafSuffixes.size());
+        leafSuffixes = ownLeafSuffixes.data();
+}
+
 length_t SuffixTree::recComputeSLPhase1(STNode* node, vector<STNode*>& A)
 {
         // for leaves, simply return the suffix index
@@ -272,7 +335,7 @@ void SuffixTree::recComputeSLPhase2(STNode* node, const vector<STNode*>& A,
                 length_t sufIdx = node->getSuffixIdx();
                 if (A[sufIdx] != NULL && A[sufIdx] != root) {
                         length_t d = A[sufIdx]->getDepth();
-                        A[sufIdx]->setSuffixLink(B[d-1]);
+                        setSuffixLink(A[sufIdx], B[d-1]);
                 }
         } else {
                 length_t d = node->getDepth();
@@ -322,8 +385,6 @@ std::ostream& SuffixTree::write(std::ostream& o) const
                   << T.substr(node->begin(), node->getEdgeLength()) << "\""
                   << ", depth=" << node->getDepth() << ", occ: " << node->getOccurence();
 
-                if (!node->isLeaf() && node != root && node->getSuffixLink() != NULL)
-                        o << " (SL: \"" << posToStr(node->getSuffixLink()) << "\")";
                 if (node->isLeaf())
                         o << " (" << node->getSuffixIdx() << ")";
                 o << "\n";
@@ -341,9 +402,8 @@ std::ostream& SuffixTree::write(std::ostream& o) const
 void SuffixTree::constructNaive()
 {
         // create a node with an empty range (it has no parent)
-        root = new STNode(0, 0);
-        node_count++;
-
+        nodes.reserve(2 * T.size() + 1);
+        root = newNode(0, 0);
 
         for (size_t i = 0; i < T.size(); i++) {
                 // find position in ST that maximally matches the prefix of suf_i(T)
@@ -364,18 +424,20 @@ void SuffixTree::constructNaive()
 
         // Maass algorithm to compute suffix links in O(n) time
         computeSuffixLinks();
+        annotateTree();
+        vector<STNodeLinks>().swap(constructionLinks);
 }
 
 /**
-I add occurence tables in every leaf node, while keeping the parents satisfied (if bit is not set in parent set in parent, until parent == null or bit is set)
-When we split a branch, I copy the bitset of the child (can be a leaf or a node) to the mid node (parent should already be fine since this isnt a new node)
-And then add the new bit to the addleaf as we do normally, recursing through parents.
+I add occurence tables in every leaf node only, so adding a leaf does not walk up its parents.
+After the tree is built the internal nodes get the union of the bits of their leaves and the range of their leaves, one subtree of the root at a time.
 */
 void SuffixTree::constructUkonen()
 {
         // create root node with an empty range (it has no parent)
-        root = new STNode(0, 0);
-        node_count ++;
+        // the implicit suffix tree has at most one leaf and one internal node per character
+        nodes.reserve(2 * T.size() + 1);
+        root = newNode(0, 0);
 
         // algorithm invariant: pos points to T[i:j-1[
         STPosition pos(root);
@@ -400,7 +462,7 @@ void SuffixTree::constructUkonen()
 
                         // add a SL from the previously created internal node
                         if (prevInternal != NULL && pos.atNode()) {
-                                prevInternal->setSuffixLink(pos.node);
+                                setSuffixLink(prevInternal, pos.node);
                                 prevInternal = NULL;
                         }
 
@@ -420,7 +482,7 @@ void SuffixTree::constructUkonen()
                         if (!pos.atNode()) {
                                 pos = splitEdge(pos); // pos points to new node
                                 if (prevInternal != NULL)
-                                        prevInternal->setSuffixLink(pos.node);
+                                        setSuffixLink(prevInternal, pos.node);
                                 prevInternal = pos.node;
                         }
 
@@ -443,6 +505,332 @@ void SuffixTree::constructUkonen()
                         // std::cerr << *this << std::endl;
                 }
         }
+
+        annotateTree();
+        vector<STNodeLinks>().swap(constructionLinks);
+        std::cerr << "[" << name << "] ST of length "<< T.size() <<  ", memory usage: " <<  ((sizeof(SuffixTree) + sizeof(STNode) * node_count) / 1024 / 1024) << "MB" << std::endl;
+}
+
+void SuffixTree::relayout(const int levels)
+{
+        if (nodes.empty()) // a mapped tree is used as it is
+                return;
+        // the new order: the root and the given levels below it breadth first
+        vector<STNode*> order;
+        order.reserve(nodes.size());
+        order.push_back(root);
+        size_t levelBegin = 0;
+        for (int level = 0; level < levels && levelBegin < order.size(); level++) {
+                size_t levelEnd = order.size();
+                for (size_t i = levelBegin; i < levelEnd; i++)
+                        for (int c = 0; c < MAX_CHAR; c++)
+                                if (order[i]->getChildNumber(c) != NULL)
+                                        order.push_back(order[i]->getChildNumber(c));
+                levelBegin = levelEnd;
+        }
+        // then the descendants of every node of the last level depth first
+        size_t levelEnd = order.size();
+        vector<STNode*> stack;
+        for (size_t i = levelBegin; i < levelEnd; i++) {
+                stack.assign(1, order[i]);
+                while (!stack.empty()) {
+                        STNode* node = stack.back();
+                        stack.pop_back();
+                        if (node != order[i])
+                                order.push_back(node);
+                        for (int c = MAX_CHAR - 1; c >= 0; c--)
+                                if (node->getChildNumber(c) != NULL)
+                                        stack.push_back(node->getChildNumber(c));
+                }
+        }
+
+        vector<uint32_t> newIndex(nodes.size());
+        for (size_t i = 0; i < order.size(); i++)
+                newIndex[nodeIndex(order[i])] = i;
+        vector<STNode> block;
+        block.reserve(order.size());
+        for (STNode* node : order)
+                block.push_back(*node);
+        for (size_t i = 0; i < order.size(); i++)
+                for (int c = 0; c < MAX_CHAR; c++)
+                        if (order[i]->getChildNumber(c) != NULL)
+                                block[i].child[c] = block[i].linkTo(&block[newIndex[nodeIndex(order[i]->getChildNumber(c))]]);
+        nodes.swap(block);
+        root = nodes.data();
+}
+
+unsigned char SuffixTree::getLeafBit(const size_t suffixIndex) const
+{
+        size_t stringId = std::upper_bound(stringStartPositions.begin(), stringStartPositions.end(), suffixIndex) - stringStartPositions.begin() - 1;
+        return order_of_species_mapping[stringId / reverseComplementFactor];
+}
+
+void SuffixTree::buildPartition(const vector<int>& SA, const vector<int>& LCP, const size_t first, const size_t last,
+                                vector<STNode>& block) const
+{
+        block.reserve(2 * (last - first) + 1);
+        block.emplace_back(0, 0);
+        // the path from the top to the last leaf, with the depth of every node
+        vector<pair<STNode*, size_t> > path;
+        path.emplace_back(&block[0], 0);
+        size_t lcp = 0; // with the previous suffix that got a leaf, 0 for the first suffix of the partition
+        for (size_t k = first; k < last; k++) {
+                size_t i = SA[k];
+                if (k > first)
+                        lcp = std::min(lcp, (size_t)LCP[k]);
+                // suf_i(T) is a prefix of the next suffix, the implicit tree has no leaf for it
+                if (k + 1 < SA.size() && (size_t)LCP[k + 1] == T.size() - i)
+                        continue;
+                STNode* chd = NULL;
+                while (path.back().second > lcp) {
+                        chd = path.back().first;
+                        path.pop_back();
+                }
+                STNode* node = path.back().first;
+                if (path.back().second < lcp) { // split the edge to chd
+                        block.emplace_back(chd->begin(), chd->begin() + (lcp - path.back().second));
+                        STNode* mid = &block.back();
+                        chd->setBegin(mid->end());
+                        node->setChild(T[mid->begin()], mid);
+                        mid->setChild(T[chd->begin()], chd);
+                        path.emplace_back(mid, lcp);
+                        node = mid;
+                }
+                block.emplace_back(i + lcp, T.size());
+                STNode* leaf = &block.back();
+                leaf->setSuffixIdx(i);
+                leaf->setOccurenceBitForGST(getLeafBit(i));
+                node->setChild(T[i + lcp], leaf);
+                path.emplace_back(leaf, T.size() - i);
+                lcp = T.size();
+        }
+}
+
+// ----------------------------------------------------------------------------
+// SUFFIX ARRAY BY INDUCED SORTING (Nong, Zhang and Chan, 2009)
+// ----------------------------------------------------------------------------
+
+// start (or end) of the bucket of every character
+static void getBuckets(const int* s, const int n, const int K, vector<int>& bucket, const bool end)
+{
+        std::fill(bucket.begin(), bucket.end(), 0);
+        for (int i = 0; i < n; i++)
+                bucket[s[i]]++;
+        for (int c = 0, sum = 0; c < K; c++) {
+                sum += bucket[c];
+                bucket[c] = end ? sum : sum - bucket[c];
+        }
+}
+
+// sorts the L-type suffixes from the sorted suffixes in SA, then the S-type ones
+static void induceSort(const int* s, int* SA, const int n, const int K, const vector<bool>& stype, vector<int>& bucket)
+{
+        getBuckets(s, n, K, bucket, false);
+        for (int i = 0; i < n; i++) {
+                int j = SA[i] - 1;
+                if (j >= 0 && !stype[j])
+                        SA[bucket[s[j]]++] = j;
+        }
+        getBuckets(s, n, K, bucket, true);
+        for (int i = n - 1; i >= 0; i--) {
+                int j = SA[i] - 1;
+                if (j >= 0 && stype[j])
+                        SA[--bucket[s[j]]] = j;
+        }
+}
+
+/**
+Suffix array of s[0, n[ over the characters [0, K[, s[n-1] is a unique sentinel 0 and n >= 2.
+The sorted LMS substrings are named, the suffixes of the reduced string are sorted recursively in the first half of SA
+and induce the order of all suffixes.
+*/
+static void suffixArray(const int* s, int* SA, const int n, const int K)
+{
+        vector<bool> stype(n);
+        stype[n - 1] = true;
+        stype[n - 2] = false;
+        for (int i = n - 3; i >= 0; i--)
+                stype[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && stype[i + 1]);
+        auto isLMS = [&](int i) { return i > 0 && stype[i] && !stype[i - 1]; };
+
+        // sort the LMS substrings
+        vector<int> bucket(K);
+        getBuckets(s, n, K, bucket, true);
+        std::fill(SA, SA + n, -1);
+        for (int i = 1; i < n; i++)
+                if (isLMS(i))
+                        SA[--bucket[s[i]]] = i;
+        induceSort(s, SA, n, K, stype, bucket);
+
+        // name them, equal substrings get the same name
+        int n1 = 0;
+        for (int i = 0; i < n; i++)
+                if (isLMS(SA[i]))
+                        SA[n1++] = SA[i];
+        std::fill(SA + n1, SA + n, -1);
+        int names = 0;
+        for (int i = 0, previous = -1; i < n1; i++) {
+                int pos = SA[i];
+                bool different = previous < 0;
+                for (int d = 0; !different; d++) {
+                        if (s[pos + d] != s[previous + d] || stype[pos + d] != stype[previous + d])
+                                different = true;
+                        else if (d > 0 && (isLMS(pos + d) || isLMS(previous + d)))
+                                break;
+                }
+                if (different) {
+                        names++;
+                        previous = pos;
+                }
+                SA[n1 + pos / 2] = names - 1;
+        }
+        for (int i = n - 1, j = n - 1; i >= n1; i--)
+                if (SA[i] >= 0)
+                        SA[j--] = SA[i];
+
+        // sort the suffixes of the reduced string
+        int* s1 = SA + n - n1;
+        if (names < n1)
+                suffixArray(s1, SA, n1, names);
+        else
+                for (int i = 0; i < n1; i++)
+                        SA[s1[i]] = i;
+
+        // put the sorted LMS suffixes at the end of their buckets and induce the others
+        getBuckets(s, n, K, bucket, true);
+        for (int i = 1, j = 0; i < n; i++)
+                if (isLMS(i))
+                        s1[j++] = i;
+        for (int i = 0; i < n1; i++)
+                SA[i] = s1[SA[i]];
+        std::fill(SA + n1, SA + n, -1);
+        for (int i = n1 - 1; i >= 0; i--) {
+                int j = SA[i];
+                SA[i] = -1;
+                SA[--bucket[s[j]]] = j;
+        }
+        induceSort(s, SA, n, K, stype, bucket);
+}
+
+void SuffixTree::constructPartitioned(const int threads)
+{
+        // suffix array of T with the characters in the order of the children, followed by a sentinel
+        const int n = T.size();
+        vector<int> SA(n + 1);
+        {
+                vector<int> s(n + 1);
+                for (int i = 0; i < n; i++)
+                        s[i] = STNode::charToIndex[(unsigned char)T[i]] + 1;
+                s[n] = 0;
+                suffixArray(s.data(), SA.data(), n + 1, MAX_CHAR + 1);
+        }
+        SA.erase(SA.begin()); // the sentinel
+
+        // LCP array (Kasai et al., 2001)
+        vector<int> LCP(n, 0);
+        {
+                vector<int> rank(n);
+                for (int k = 0; k < n; k++)
+                        rank[SA[k]] = k;
+                for (int i = 0, h = 0; i < n; i++) {
+                        if (rank[i] == 0) {
+                                h = 0;
+                                continue;
+                        }
+                        int j = SA[rank[i] - 1];
+                        while (i + h < n && j + h < n && T[i + h] == T[j + h])
+                                h++;
+                        LCP[rank[i]] = h;
+                        if (h > 0)
+                                h--;
+                }
+        }
+
+        // the suffixes with the same first two characters are a range of SA, the last suffix has only one
+        vector<pair<size_t, size_t> > partitions(MAX_CHAR * MAX_CHAR, make_pair(0, 0));
+        for (size_t k = 0; k < (size_t)n; k++) {
+                size_t i = SA[k];
+                if (i + 1 == (size_t)n)
+                        continue;
+                pair<size_t, size_t>& range = partitions[STNode::charToIndex[(unsigned char)T[i]] * MAX_CHAR + STNode::charToIndex[(unsigned char)T[i + 1]]];
+                if (range.first == range.second)
+                        range.first = k;
+                range.second = k + 1;
+        }
+        auto partitionSize = [&](size_t p) { return partitions[p].second - partitions[p].first; };
+
+        // the largest partitions first, so no thread ends with a large one
+        vector<size_t> order;
+        for (size_t p = 0; p < partitions.size(); p++)
+                if (partitionSize(p) > 0)
+                        order.push_back(p);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return partitionSize(a) > partitionSize(b); });
+        vector<vector<STNode> > blocks(partitions.size());
+        std::atomic<size_t> next(0);
+        auto build = [&]() {
+                for (size_t k = next.fetch_add(1); k < order.size(); k = next.fetch_add(1))
+                        buildPartition(SA, LCP, partitions[order[k]].first, partitions[order[k]].second, blocks[order[k]]);
+        };
+        vector<std::thread> pool;
+        for (int t = 1; t < threads; t++)
+                pool.emplace_back(build);
+        build();
+        for (std::thread& thread : pool)
+                thread.join();
+
+        // the root, a node of depth 1 for every first character with more than one partition, then the blocks without their top
+        size_t total = 2 + MAX_CHAR;
+        for (const vector<STNode>& block : blocks)
+                total += block.size();
+        nodes.reserve(total);
+        root = newNode(0, 0);
+        vector<STNode*> branches(MAX_CHAR, NULL);
+        for (int c = 0; c < MAX_CHAR; c++) {
+                int first = -1, count = 0;
+                for (int d = 0; d < MAX_CHAR; d++) {
+                        if (partitionSize(c * MAX_CHAR + d) > 0) {
+                                if (first < 0) first = d;
+                                count++;
+                        }
+                }
+                if (count > 1) {
+                        length_t begin = SA[partitions[c * MAX_CHAR + first].first];
+                        branches[c] = newNode(begin, begin + 1);
+                        root->setChild(T[begin], branches[c]);
+                }
+        }
+        for (size_t p = 0; p < blocks.size(); p++) {
+                vector<STNode>& block = blocks[p];
+                if (block.size() < 2)
+                        continue;
+                // the links within the block stay valid when it is moved as a whole
+                STNode* blockTop = NULL;
+                for (int c = 0; c < MAX_CHAR && blockTop == NULL; c++)
+                        blockTop = block[0].getChildNumber(c);
+                size_t offset = nodes.size();
+                nodes.insert(nodes.end(), block.begin() + 1, block.end());
+                STNode* top = &nodes[offset + (blockTop - &block[0]) - 1];
+                vector<STNode>().swap(block);
+                STNode* branch = branches[p / MAX_CHAR];
+                if (branch != NULL) {
+                        top->setBegin(top->begin() + 1);
+                        branch->setChild(T[top->begin()], top);
+                } else {
+                        root->setChild(T[top->begin()], top);
+                }
+        }
+        // the last suffix only gets a leaf if its character occurs nowhere else
+        size_t last = T.size() - 1;
+        if (root->getChild(T[last]) == NULL) {
+                STNode* leaf = newNode(last, T.size());
+                leaf->setSuffixIdx(last);
+                leaf->setOccurenceBitForGST(getLeafBit(last));
+                root->setChild(T[last], leaf);
+        }
+        node_count = nodes.size();
+
+        annotateTree();
+        vector<STNodeLinks>().swap(constructionLinks);
         std::cerr << "[" << name << "] ST of length "<< T.size() <<  ", memory usage: " <<  ((sizeof(SuffixTree) + sizeof(STNode) * node_count) / 1024 / 1024) << "MB" << std::endl;
 }
 
@@ -481,146 +869,266 @@ void SuffixTree::addMotifToMap(const short& maxlen, const std::string& currentMo
     }
 }
 
+// output of a valid motif, chosen once per family instead of an indirect call per motif
+struct SuffixTree::BinarySink {
+    static void emit(SuffixTree& tree, const short& maxlen, const std::string& currentMotif, const BLSScore& bls, const occurence_bits& occurence, std::ostream& out) {
+        tree.printMotifBinary(maxlen, currentMotif, bls, occurence, out);
+    }
+};
+struct SuffixTree::StringSink {
+    static void emit(SuffixTree& tree, const short& maxlen, const std::string& currentMotif, const BLSScore& bls, const occurence_bits& occurence, std::ostream& out) {
+        tree.printMotifString(maxlen, currentMotif, bls, occurence, out);
+    }
+};
+struct SuffixTree::MapSink {
+    static void emit(SuffixTree& tree, const short& maxlen, const std::string& currentMotif, const BLSScore& bls, const occurence_bits& occurence, std::ostream& out) {
+        tree.addMotifToMap(maxlen, currentMotif, bls, occurence);
+    }
+};
+
+// forward strand index: the reverse complement of a motif is listed by its start positions once it has at most this many
+static const size_t MAX_LISTED_STARTS = 4096;
+
+// the IUPAC mask of the complement of a letter: A <-> T and C <-> G
+static inline unsigned char complementMask(const unsigned char mask) {
+    return ((mask & BASE_A) << 3) | ((mask & BASE_C) << 1) | ((mask & BASE_G) >> 1) | ((mask & BASE_T) >> 3);
+}
+
+// the mask of a base in T, 0 for N and the delimiters, which no letter of a motif matches in the tree either
+static inline unsigned char baseMask(const char c) {
+    switch (c) {
+        case 'A': return BASE_A;
+        case 'C': return BASE_C;
+        case 'G': return BASE_G;
+        case 'T': return BASE_T;
+        default: return 0;
+    }
+}
+
 /**
-Recurse into the tree with degenerate letters, meaning we need a vector of positions we are currently at!
+Walk the tree with degenerate letters, meaning we need a vector of positions we are currently at!
 with 3 N's the most number of positions is 4*4*4= 64 positions to check.
 To check validity of the motif with regard to the BLS score, we do the or operation on the mask of every position and then check this occurence bitset in the bls score function.
-If score is equal to or more than the threshold then we keep the motif if its less we should stop the recursion!
+If score is equal to or more than the threshold then we keep the motif if its less we should stop extending it!
+Only group representatives are printed, so a branch is not walked if neither its motif nor any extension within the length range is one.
+The motifs are enumerated depth first with an explicit stack of frames, one per motif character, in the same order as a recursion.
+A tree without the reverse complement strand (reverseComplementFactor 1) adds the occurence of the reverse complement of every prefix,
+which gives the same motifs as the tree with both strands. Extending the motif puts the complement of the letter in front of its reverse
+complement, which a suffix tree cannot follow: the reverse complement is matched from the root and, once it has few occurences, its start
+positions in T are listed and passed down the frames, an extension keeps the start positions that are preceded by the complement of the letter.
 */
-void SuffixTree::recPrintMotifs(const std::pair<short, short>& l,
-    const int& maxDegenerateLetters, const BLSScore& bls, STPositionsPerLetter& matchingNodes,
-    const std::string& prefix, int curDegenerateLetters, std::ostream& out)
+template<Alphabet A, class Sink>
+void SuffixTree::enumerateMotifs(const std::pair<short, short>& l,
+    const int& maxDegenerateLetters, const BLSScore& bls, STPositionsPerLetter& matchingNodes, std::ostream& out)
 {
+    std::vector<EnumerationFrame> frames(l.second + 1);
+    std::string motif; // the prefix of frame d is motif[0, d[
+    motif.reserve(l.second);
     occurence_bits occurence(0);
-    const std::vector<IupacMask>* curalphabet = (curDegenerateLetters == maxDegenerateLetters) ?  &exactAlphabet : this->alphabet;
+    int depth = 0;
+    frames[0].next = 0;
+    frames[0].degenerateLetters = 0;
+    frames[0].extensions = (maxDegenerateLetters == 0) ? exactExtensions : extensionCount<A>;
+    frames[0].reverseComplementOccurence = ~(occurence_bits)0;
+    frames[0].reverseComplementListed = false;
+    nodesVisited++;
+    const bool forwardStrandOnly = reverseComplementFactor == 1;
+    STPositionsPerLetter reverseComplementPositions(forwardStrandOnly ? l.second : 0, maxDegenerateLetters);
+    std::vector<std::vector<length_t>> reverseComplementStarts(forwardStrandOnly ? l.second + 1 : 0); // per depth, if the frame has them listed
+    std::vector<occurence_bits> stringOccurence; // the occurence bit of the species of every string
+    if (forwardStrandOnly) {
+        reverseComplementPositions.list[0].addSTPosition(root);
+        for (size_t s : order_of_species_mapping)
+            stringOccurence.push_back(1 << s);
+    }
 
-    for (IupacMask extension : *curalphabet) {
+    while (depth >= 0) {
+        EnumerationFrame& frame = frames[depth];
+        if (frame.next == frame.extensions) { // all extensions of this prefix are done
+            depth--;
+            continue;
+        }
+        const int e = frame.next++;
+        const bool degenerate = e >= exactExtensions;
+        GroupBalance balance = frame.balance;
+        balance.add(extensionList[e].getRepresentation());
+        if(!(depth + 1 >= l.first && balance.isRepresentative()) && !(depth + 2 < l.second && balance.canBecomeRepresentative(l.second - 2 - depth)))
+            continue;
+        positionsAdvanced += matchingNodes.list[depth].validPositions;
         // increment position in positions list if possible
-        if(extension.isDegenerate()){
-            advanceIupacCharacter(extension, prefix.size(), matchingNodes, occurence);
+        if(degenerate){
+            advanceIupacCharacter(extensionList[e], depth, matchingNodes, occurence);
         } else {
-            advanceExactCharacter(extension, prefix.size(), matchingNodes, occurence);
+            advanceExactCharacter(extensionList[e], depth, matchingNodes, occurence);
         }
 
+        occurence_bits reverseComplementOccurence = 0;
+        bool reverseComplementListed = false;
+        if(forwardStrandOnly && frame.reverseComplementOccurence != 0) { // the reverse complement of the prefix is part of the one of the motif
+            if(depth + 1 < l.first && bls.greaterThanMinThreshold(occurence)) {
+                reverseComplementOccurence = ~(occurence_bits)0; // not printed and extended anyway, left to the extensions
+            } else if(frame.reverseComplementListed) {
+                reverseComplementOccurence = prependCharacter(complementMask(extensionList[e].getMask()), reverseComplementStarts[depth], stringOccurence, reverseComplementStarts[depth + 1]);
+                reverseComplementListed = true;
+                occurence |= reverseComplementOccurence;
+            } else {
+                motif.resize(depth);
+                motif.push_back(extensionList[e].getRepresentation());
+                reverseComplementOccurence = getReverseComplementOccurence(motif, reverseComplementPositions);
+                // the start positions are only needed by the extensions of the motif
+                reverseComplementListed = reverseComplementOccurence != 0 && depth + 2 < l.second
+                    && listStartPositions(reverseComplementPositions.list[depth + 1], MAX_LISTED_STARTS, reverseComplementStarts[depth + 1]);
+                occurence |= reverseComplementOccurence;
+            }
+        }
         // can be extended if at least one new position is found!
-        if(matchingNodes.list[prefix.size() + 1].validPositions > 0) {
-            std::string currentMotif = prefix + extension.getRepresentation();
-            iteratorCount++;
-            // if(iteratorCount % 1000000 == 0) std::cerr << "\33[2K\r" << iteratorCount / 1000000 << " M motifs iterated" << std::flush;
-            if(bls.greaterThanMinThreshold(occurence)) {
-
-               if((unsigned char) currentMotif.length() >= l.first) { // print motif if correct length!
-                    if(motifmap == NULL) {
-                        (this->*printMotif)(l.second, currentMotif, bls, occurence, out);
-                    } else {
-                        addMotifToMap(l.second, currentMotif, bls, occurence);
-                    }
-               }
-
-                if((unsigned char) currentMotif.length() +  1 == l.second) { // max length reached, we do not recurse into the next extension
-                    continue; // continue for loop/go to next extension
-                } else { // recursive function to add one more letter to the motifs
-                    recPrintMotifs(l, maxDegenerateLetters, bls, matchingNodes, currentMotif,
-                                   (extension.isDegenerate() ? curDegenerateLetters + 1 : curDegenerateLetters), out);
-               }
-           }
+        if(matchingNodes.list[depth + 1].validPositions == 0 && reverseComplementOccurence == 0)
+            continue;
+        motif.resize(depth);
+        motif.push_back(extensionList[e].getRepresentation());
+        iteratorCount++;
+        // if(iteratorCount % 1000000 == 0) std::cerr << "\33[2K\r" << iteratorCount / 1000000 << " M motifs iterated" << std::flush;
+        if(!bls.greaterThanMinThreshold(occurence))
+            continue;
+        if((unsigned char) motif.length() >= l.first && balance.isRepresentative()) { // print motif if correct length!
+            Sink::emit(*this, l.second, motif, bls, occurence, out);
         }
+        if((unsigned char) motif.length() +  1 == l.second) // max length reached, we do not extend this motif
+            continue;
+        // add one more letter to the motif
+        EnumerationFrame& child = frames[++depth];
+        child.next = 0;
+        child.degenerateLetters = frame.degenerateLetters + degenerate;
+        child.extensions = (child.degenerateLetters == maxDegenerateLetters) ? exactExtensions : extensionCount<A>;
+        child.reverseComplementOccurence = reverseComplementOccurence;
+        child.reverseComplementListed = reverseComplementListed;
+        child.balance = balance;
+        nodesVisited++;
     }
 }
 
-
-
-
-// the return vector is a vector of positions, <# of string, pos in that string>
-void SuffixTree::recPrintMotifsWithPositions(const std::pair<short, short>& l,
-    const int& maxDegenerateLetters, const BLSScore& bls, STPositionsPerLetter& matchingNodes, std::vector<std::pair<int, int>>& stringPositions,
-    const std::string& prefix, int curDegenerateLetters, std::ostream& out)
+// the positions of every prefix are appended to stringPositions as suffix indices, textPositions gives their string and column
+// a frame is finished after all its extensions, then the extension of its parent that led to it is finished
+template<Alphabet A, class Sink>
+void SuffixTree::enumerateMotifsWithPositions(const std::pair<short, short>& l,
+    const int& maxDegenerateLetters, const BLSScore& bls, STPositionsPerLetter& matchingNodes, std::vector<size_t>& stringPositions,
+    LocationBuffers& buffers, std::ostream& out)
 {
+    std::vector<EnumerationFrame> frames(l.second + 1);
+    std::string motif; // the prefix of frame d is motif[0, d[
+    motif.reserve(l.second);
     occurence_bits occurence(0);
-
-//TODO fix max positions -> but still find postions here and return to above
-    int i = 0;
-    int validChildren = 0;
-    // std::string motif = "AAAAAARWCARA";
-
-    if((unsigned char) prefix.length() +  1 < l.second) { // only extend if possible, else only get positions
-        const std::vector<IupacMask>* curalphabet = (curDegenerateLetters == maxDegenerateLetters) ?  &exactAlphabet : this->alphabet;
-        for (IupacMask extension : *curalphabet) {
-            if(extension.isDegenerate()){
-                advanceIupacCharacter(extension, prefix.size(), matchingNodes, occurence);
+    int depth = 0;
+
+    auto enter = [&](const int d, const int degenerateLetters) {
+        EnumerationFrame& frame = frames[d];
+        frame.next = 0;
+        frame.degenerateLetters = degenerateLetters;
+        frame.validChildren = 0;
+        if(d + 1 < l.second) { // only extend if possible, else only get positions
+            frame.extensions = (degenerateLetters == maxDegenerateLetters) ? exactExtensions : extensionCount<A>;
+        } else {
+            frame.extensions = 0;
+        }
+        nodesVisited++;
+    };
+    // all positions of the current extension of frame d are in [frame.start, stringPositions.size()[
+    auto finishExtension = [&](const int d) {
+        EnumerationFrame& frame = frames[d];
+        if(!frame.degenerate) { // only keep positions of exact extensions for this prefix
+            frame.validChildren += matchingNodes.list[d + 1].validPositions;
+        }
+        motif.resize(d + 1);
+        // the positions of every motif are collected for its prefix, but only group representatives are scored
+        GroupBalance balance = frame.balance;
+        balance.add(motif[d]);
+        if((unsigned char) motif.length() >= l.first && stringPositions.size() - frame.start > 1 && balance.isRepresentative()) { // needs at least more than 1 read to have a bls score >0!!
+            getBestOccurence(stringPositions, frame.start, bls, occurence, buffers);
+            if(bls.greaterThanMinThreshold(occurence)) { // print motif if correct length
+                Sink::emit(*this, l.second, motif, bls, occurence, out);
+            }
+        }
+        if(frame.degenerate) {
+            stringPositions.resize(frame.start);
+        }
+    };
+
+    enter(0, 0);
+    while (depth >= 0) {
+        EnumerationFrame& frame = frames[depth];
+        if (frame.next < frame.extensions) {
+            const int e = frame.next++;
+            frame.degenerate = e >= exactExtensions;
+            positionsAdvanced += matchingNodes.list[depth].validPositions;
+            if(frame.degenerate){
+                advanceIupacCharacter(extensionList[e], depth, matchingNodes, occurence);
             } else {
-                advanceExactCharacter(extension, prefix.size(), matchingNodes, occurence);
+                advanceExactCharacter(extensionList[e], depth, matchingNodes, occurence);
             }
-
-            // if(motif == (prefix + extension.getRepresentation()).substr(0, motif.length())) {
-            //     std::cerr << prefix + extension.getRepresentation() << " found at " << matchingNodes.list[prefix.size() + 1].validPositions << " positions\n";
-            // }
             // can be extended if at least one new position is found!
-            if(matchingNodes.list[prefix.size() + 1].validPositions > 0) {
-                std::vector<std::pair<int, int>> newPositions;
-                std::string currentMotif = prefix + extension.getRepresentation();
-                if ((unsigned char) currentMotif.length() +  1 == l.second) {
-                    getLeafPositions(newPositions, matchingNodes.list[prefix.size() + 1].list, matchingNodes.list[prefix.size() + 1].validPositions);
-                } else {
-                    recPrintMotifsWithPositions(l, maxDegenerateLetters, bls, matchingNodes, newPositions,
-                                                currentMotif, (extension.isDegenerate() ? curDegenerateLetters + 1 : curDegenerateLetters), out);
-                }
-                if(!extension.isDegenerate()) { // only add positions of exact extensions
-                    validChildren += matchingNodes.list[prefix.size() + 1].validPositions;
-                    for (auto pos: newPositions) { // add to positions of this prefix
-                         // std::cerr << "pos: " << pos.first << ", " << pos.second << std::endl;
-                         stringPositions.push_back(pos);
-                    }
-                }
-
-                if((unsigned char) currentMotif.length() >= l.first && newPositions.size() > 1) { // needs at least more than 1 read to have a bls score >0!!
-                    getBestOccurence(newPositions, bls, occurence);
-                    // if(motif == (currentMotif).substr(0, motif.length())) {
-                    //     std::cerr << "valid positions found for " << currentMotif << " with " << newPositions.size() << " positions found with occ: " << +occurence << std::endl;
-                    //     for (auto p: newPositions)
-                    //         std::cerr << "pos : " << p.first <<", " << p.second << std::endl;
-                    // }
-                    if(bls.greaterThanMinThreshold(occurence)) { // print motif if correct length
-                        (this->*printMotif)(l.second, currentMotif, bls, occurence, out);
-                    }
-                }
+            if(matchingNodes.list[depth + 1].validPositions == 0)
+                continue;
+            frame.start = stringPositions.size();
+            motif.resize(depth);
+            motif.push_back(extensionList[e].getRepresentation());
+            if ((unsigned char) motif.length() +  1 == l.second) {
+                getLeafPositions(stringPositions, matchingNodes.list[depth + 1].list, matchingNodes.list[depth + 1].validPositions, buffers);
+                finishExtension(depth);
+            } else {
+                enter(depth + 1, frame.degenerateLetters + frame.degenerate);
+                frames[depth + 1].balance = frame.balance;
+                frames[depth + 1].balance.add(motif[depth]);
+                depth++;
             }
-            i++;
+        } else {
+            if(frame.validChildren == 0) {
+                // std::cerr << prefix << " cannot be extended further, getting all positions from position list" << std::endl;
+                getLeafPositions(stringPositions, matchingNodes.list[depth].list, matchingNodes.list[depth].validPositions, buffers);
+            } else {
+                // now find positions in current nodes that continue with a '-' (filler)
+                getPositionsStartingWithDelimiter(stringPositions, matchingNodes.list[depth].list, matchingNodes.list[depth].validPositions, buffers);
+            }
+            depth--;
+            if (depth >= 0)
+                finishExtension(depth);
         }
     }
-    if(validChildren == 0) {
-        // std::cerr << prefix << " cannot be extended further, getting all positions from position list" << std::endl;
-        getLeafPositions(stringPositions, matchingNodes.list[prefix.size()].list, matchingNodes.list[prefix.size()].validPositions);
-    } else {
-        // now find positions in current nodes that continue with a '-' (filler)
-        getPositionsStartingWithDelimiter(stringPositions, matchingNodes.list[prefix.size()].list, matchingNodes.list[prefix.size()].validPositions);
-    }
-
 }
 
 // TODO fix bug with scores here, is incorrect now...
-void SuffixTree::getBestOccurence(std::vector<std::pair<int, int>>& positions, const BLSScore& bls, occurence_bits& occurence) {
+void SuffixTree::getBestOccurence(const std::vector<size_t>& positions, const BLSScore& bls, occurence_bits& occurence) {
+    LocationBuffers buffers;
+    getBestOccurence(positions, 0, bls, occurence, buffers);
+}
+void SuffixTree::getBestOccurence(const std::vector<size_t>& positions, const size_t start, const BLSScore& bls, occurence_bits& occurence, LocationBuffers& buffers) {
     occurence = 0;
     float maxBls = 0;
-    sort(positions.begin(), positions.end(), SuffixTree::positionPairSort);
-    size_t i = 0;
-    while(i < positions.size()) {
-        occurence_bits motifOcc(0);
-        occurence_bits rcOcc(0);
-        int pos = positions[i].second;
-        if((i + 1 < positions.size() && pos != positions[i].second) || i == positions.size() - 1) {
-             // if only one occurence or new pos as last pos so also only one occurence increment and skip
-            i++;
-            continue;
+    std::vector<occurence_bits>& columnOcc = buffers.columnOcc;
+    std::vector<occurence_bits>& columnRcOcc = buffers.columnRcOcc;
+    std::vector<uint32_t>& columns = buffers.columns;
+    columns.clear();
+    // accumulate the occurence of every column, columns are bounded by the length of a gene so this is a direct index
+    for(size_t i = start; i < positions.size(); i++) {
+        const TextPosition& textPos = textPositions[positions[i]];
+        uint32_t pos = textPos.column;
+        if(pos >= columnOcc.size()) {
+            columnOcc.resize(pos + 1, 0);
+            columnRcOcc.resize(pos + 1, 0);
         }
-        while(i < positions.size() && pos == positions[i].second) {
-            if(positions[i].first % reverseComplementFactor == 0) {
-                motifOcc |= 1 << (positions[i].first / reverseComplementFactor);
-            } else {
-                rcOcc |= 1 << (positions[i].first / reverseComplementFactor);
-            }
-            i++;
+        if(columnOcc[pos] == 0 && columnRcOcc[pos] == 0) {
+            columns.push_back(pos);
+        }
+        if(textPos.reverseComplement) {
+            columnRcOcc[pos] |= textPos.speciesBit;
+        } else {
+            columnOcc[pos] |= textPos.speciesBit;
         }
+    }
+    for(uint32_t pos : columns) {
+        occurence_bits motifOcc = columnOcc[pos];
+        occurence_bits rcOcc = columnRcOcc[pos];
+        columnOcc[pos] = 0; // leave the accumulator empty for the next call
+        columnRcOcc[pos] = 0;
         // std::cerr << "pos: " << pos << " -> occ: " << +motifOcc << " rvOcc: " << +rcOcc << std::endl;
         if(__builtin_popcountll(motifOcc) > 1) {
             iteratorCount++;
@@ -642,43 +1150,106 @@ void SuffixTree::getBestOccurence(std::vector<std::pair<int, int>>& positions, c
         }
     }
 }
+// integers are formatted directly into the output buffer, this is the hot path of location mode
+static inline void appendNumber(std::string& out, const size_t number) {
+    char buffer[24];
+    char* end = std::to_chars(buffer, buffer + sizeof(buffer), number).ptr;
+    out.append(buffer, end - buffer);
+}
+template<typename T>
+static inline void appendBinary(std::string& out, const T value) {
+    out.append((const char*)&value, sizeof(T));
+}
+
 void SuffixTree::getLeafPositionsAndPrint(const std::vector<STPosition>& matchingNodes, const size_t size,
-std::ostream& out, const std::string &motif, const float blsScore) const {
-    out << motif << "\t" << blsScore << '\t';
-    std::vector<size_t> occ;
+LocationBuffers& buffers, const std::string &motif, const float blsScore, const bool binaryPositions) const {
+    std::vector<size_t>& occ = buffers.occ;
+    std::string& out = buffers.output;
+    occ.clear();
     for(size_t i = 0; i < size; i++) {
         getOccurrences(matchingNodes[i], occ);
     }
     std::sort(occ.begin(), occ.end());
-    int stringId = 1, geneId = 1;
-    size_t i = 0;
-    while(occ[i] >= stringStartPositions[stringId]) { stringId++;} // find the correct string id for this occurence
-    while(occ[i] >= next_gene_locations[geneId]) { geneId++;} // find the correct string id for this occurence
-    out << gene_names[geneId-1] << (((stringId - 1) & 1) ? "@-" : "@+") << occ[i] - next_gene_locations[geneId-1];
-    i++;
-    for (; i< occ.size(); i++) {
-        while(occ[i] >= stringStartPositions[stringId]) { stringId++;} // find the correct string id for this occurence
-        while(occ[i] >= next_gene_locations[geneId]) { geneId++;} // find the correct string id for this occurence
-        out << ';' << gene_names[geneId-1] << (((stringId - 1) & 1) ? "@-" : "@+")  << occ[i] - next_gene_locations[geneId-1];
+    if(binaryPositions) {
+        out.push_back((char)motif.size());
+        out.append(motif);
+        appendBinary<float>(out, blsScore);
+        appendBinary<uint32_t>(out, occ.size());
+    } else {
+        char score[32];
+        char* scoreEnd = std::to_chars(score, score + sizeof(score), blsScore, std::chars_format::general, 6).ptr; // same as the default ostream format
+        out.append(motif);
+        out.push_back('\t');
+        out.append(score, scoreEnd - score);
+        out.push_back('\t');
     }
-    out << '\n';
+    // occurences are sorted, so the string and gene of the next occurence are found by a binary search starting from the current ones
+    auto stringId = stringStartPositions.begin() + 1;
+    auto geneId = next_gene_locations.begin() + 1;
+    for (size_t i = 0; i < occ.size(); i++) {
+        stringId = std::upper_bound(stringId, stringStartPositions.end(), occ[i]); // find the correct string id for this occurence
+        geneId = std::upper_bound(geneId, next_gene_locations.end(), occ[i]); // find the correct gene id for this occurence
+        size_t gene = geneId - next_gene_locations.begin() - 1;
+        bool reverseComplement = (stringId - stringStartPositions.begin() - 1) & 1;
+        if(binaryPositions) {
+            appendBinary<uint32_t>(out, (gene << 1) | reverseComplement);
+            appendBinary<uint32_t>(out, occ[i] - next_gene_locations[gene]);
+        } else {
+            if(i > 0) out.push_back(';');
+            out.append(gene_names[gene]);
+            out.append(reverseComplement ? "@-" : "@+");
+            appendNumber(out, occ[i] - next_gene_locations[gene]);
+        }
+    }
+    if(!binaryPositions) out.push_back('\n');
+}
+
+void SuffixTree::writeGeneTable(std::ostream& out) const {
+    std::string table;
+    appendBinary<uint32_t>(table, name.size());
+    table.append(name);
+    appendBinary<uint32_t>(table, gene_names.size());
+    for (const std::string& gene : gene_names) {
+        appendBinary<uint32_t>(table, gene.size());
+        table.append(gene);
+    }
+    out.write(table.data(), table.size());
+}
+
+void SuffixTree::buildTextPositions() {
+    std::vector<TextPosition>& textPositions = ownTextPositions;
+    textPositions.resize(T.size() + 1);
+    for(size_t stringId = 0; stringId < stringStartPositions.size(); stringId++) {
+        size_t begin = stringStartPositions[stringId];
+        size_t end = std::min(stringId + 1 < stringStartPositions.size() ? stringStartPositions[stringId + 1] : textPositions.size(), textPositions.size());
+        if(begin >= end) continue; // the last start position only closes the last string
+        TextPosition textPos;
+        textPos.reverseComplement = stringId % reverseComplementFactor != 0;
+        textPos.speciesBit = 1 << (stringId / reverseComplementFactor);
+        for(size_t p = begin; p < end; p++) {
+            textPos.column = p - begin;
+            textPositions[p] = textPos;
+        }
+    }
+    this->textPositions = textPositions.data();
+}
+
+std::pair<int, int> SuffixTree::getStringPosition(const size_t p) const {
+    const TextPosition& textPos = textPositions[p];
+    return std::pair<int, int>(__builtin_ctz(textPos.speciesBit) * reverseComplementFactor + textPos.reverseComplement, textPos.column);
 }
 
 void SuffixTree::getLeafPositions(std::vector<std::pair<int, int>>& positions, const std::vector<STPosition>& matchingNodes, const size_t size) const {
-    std::vector<size_t> occ;
-    for(size_t i = 0; i < size; i++) {
-        getOccurrences(matchingNodes[i], occ);
+    LocationBuffers buffers;
+    getLeafPositions(buffers.occ, matchingNodes, size, buffers);
+    for(size_t p : buffers.occ) {
+        positions.push_back(getStringPosition(p));
     }
-    std::sort(occ.begin(), occ.end());
-    int stringId = 1;
-    // std::cerr << occ.size() << " leaf positions from " << size << " node positions " << std::endl;
-    for(auto p : occ) {
-        while(p >= stringStartPositions[stringId]) { stringId++;} // find the correct string id for this occurence
-        int posInString = p - stringStartPositions[stringId - 1];
-        // std::cerr << p << " -> [" << stringId - 1 << ", " << posInString << "], ";
-        positions.push_back(std::pair<int, int>(stringId - 1, posInString));
+}
+void SuffixTree::getLeafPositions(std::vector<size_t>& positions, const std::vector<STPosition>& matchingNodes, const size_t size, LocationBuffers& buffers) const {
+    for(size_t i = 0; i < size; i++) {
+        getOccurrences(matchingNodes[i], positions);
     }
-    // std::cerr << std::endl;
 }
 void SuffixTree::printMotifPositions(std::ostream& out, const std::string &motif, std::vector<std::pair<int, int>> positions, const float blsScore) {
     out << motif << "\t" << blsScore << '\t';
@@ -696,8 +1267,7 @@ void SuffixTree::printMotifPositions(std::ostream& out, const std::string &motif
     out << '\n';
 }
 
-void SuffixTree::getPositionsStartingWithDelimiter(std::vector<std::pair<int, int>>& positions, const std::vector<STPosition>& matchingNodes, const size_t size) const {
-    std::vector<size_t> occ;
+void SuffixTree::getPositionsStartingWithDelimiter(std::vector<size_t>& positions, const std::vector<STPosition>& matchingNodes, const size_t size, LocationBuffers& buffers) const {
     for(size_t i = 0; i < size; i++) {
         // if node is not at
         if(matchingNodes[i].atNode()) {
@@ -706,24 +1276,14 @@ void SuffixTree::getPositionsStartingWithDelimiter(std::vector<std::pair<int, in
             // if (matchingNodes[i].node->getChild(IupacMask::STRINGDELIMITER) != NULL)
                 // getOccurrences(STPosition(matchingNodes[i].node->getChild(IupacMask::STRINGDELIMITER)), occ);
             if (matchingNodes[i].node->getChild(IupacMask::DELIMITER) != NULL)
-                getOccurrences(STPosition(matchingNodes[i].node->getChild(IupacMask::DELIMITER)), occ);
+                getOccurrences(STPosition(matchingNodes[i].node->getChild(IupacMask::DELIMITER)), positions);
         } else {
              // if(T[matchingNodes[i].node->begin() + matchingNodes[i].offset] == IupacMask::FILLER ||
                 // T[matchingNodes[i].node->begin() + matchingNodes[i].offset] == IupacMask::STRINGDELIMITER ||
             if(T[matchingNodes[i].node->begin() + matchingNodes[i].offset] == IupacMask::DELIMITER)
-                getOccurrences(matchingNodes[i], occ);
+                getOccurrences(matchingNodes[i], positions);
         }
     }
-    std::sort(occ.begin(), occ.end());
-    int stringId = 1;
-    // std::cerr << occ.size() << " '" << IupacMask::DELIMITER << "' positions from " << size << " node(s) ";
-    for(auto p : occ) {
-        while(p >= stringStartPositions[stringId]) { stringId++;} // find the correct string id for this occurence
-        int posInString = p - stringStartPositions[stringId - 1];
-        // std::cerr << p << " -> [" << stringId - 1 << ", " << posInString << "], ";
-        positions.push_back(std::pair<int, int>(stringId - 1, posInString));
-    }
-    // std::cerr << std::endl;
 }
 
 void SuffixTree::advanceIupacCharacter(const IupacMask& mask, const int& characterPos, STPositionsPerLetter& positions, occurence_bits& occurence) const {
@@ -778,53 +1338,41 @@ void SuffixTree::advanceExactCharacter(const IupacMask& mask, const int& charact
     // std::cerr << "extension gives " << positions.list[characterPos + 1].validPositions << " valid positions" << std::endl;
 }
 
+occurence_bits SuffixTree::getReverseComplementOccurence(const std::string& motif, STPositionsPerLetter& positions) const {
+    occurence_bits occurence = 0;
+    const std::string reverseComplement = Motif::ReverseComplement(motif);
+    for (size_t i = 0; i < reverseComplement.size(); i++) {
+        advanceIupacCharacter(IupacMask::characterToMask[reverseComplement[i]], i, positions, occurence);
+        if (positions.list[i + 1].validPositions == 0)
+            return 0;
+    }
+    return occurence;
+}
 
-// EXACT
-const std::vector<IupacMask> SuffixTree::exactAlphabet ({
-    IupacMask(BASE_A),
-    IupacMask(BASE_C),
-    IupacMask(BASE_G),
-    IupacMask(BASE_T)
-    });
-// EXACT AND N
-const std::vector<IupacMask> SuffixTree::exactAndNAlphabet ({
-    IupacMask(BASE_A),
-    IupacMask(BASE_C),
-    IupacMask(BASE_G),
-    IupacMask(BASE_T),
-    IupacMask(IUPAC_N)
-    });
-// EXACT, TWOFOLD AND N
-const std::vector<IupacMask> SuffixTree::exactTwofoldAndNAlphabet ({
-    IupacMask(BASE_A),
-    IupacMask(BASE_C),
-    IupacMask(BASE_G),
-    IupacMask(BASE_T),
-    IupacMask(IUPAC_N),
-    IupacMask(IUPAC_R),
-    IupacMask(IUPAC_Y),
-    IupacMask(IUPAC_S),
-    IupacMask(IUPAC_W),
-    IupacMask(IUPAC_K),
-    IupacMask(IUPAC_M)
-    });
-const std::vector<IupacMask> SuffixTree::exactAndAllDegenerateAlphabet ({
-    IupacMask(BASE_A),
-    IupacMask(BASE_C),
-    IupacMask(BASE_G),
-    IupacMask(BASE_T),
-    IupacMask(IUPAC_N),
-    IupacMask(IUPAC_R),
-    IupacMask(IUPAC_Y),
-    IupacMask(IUPAC_S),
-    IupacMask(IUPAC_W),
-    IupacMask(IUPAC_K),
-    IupacMask(IUPAC_M),
-    IupacMask(IUPAC_V),
-    IupacMask(IUPAC_H),
-    IupacMask(IUPAC_D),
-    IupacMask(IUPAC_B)
-    });
+bool SuffixTree::listStartPositions(const STPositionVector& positions, const size_t maxStarts, std::vector<length_t>& starts) const {
+    size_t count = 0;
+    for (size_t i = 0; i < positions.validPositions; i++)
+        count += positions.list[i].node->getLastLeaf() - positions.list[i].node->getFirstLeaf();
+    if (count > maxStarts)
+        return false;
+    starts.clear();
+    for (size_t i = 0; i < positions.validPositions; i++)
+        starts.insert(starts.end(), leafSuffixes + positions.list[i].node->getFirstLeaf(), leafSuffixes + positions.list[i].node->getLastLeaf());
+    return true;
+}
+
+occurence_bits SuffixTree::prependCharacter(const unsigned char mask, const std::vector<length_t>& starts, const std::vector<occurence_bits>& stringOccurence,
+    std::vector<length_t>& extended) const {
+    occurence_bits occurence = 0;
+    extended.clear();
+    for (length_t p : starts) {
+        if (p > 0 && (baseMask(T[p - 1]) & mask) != 0) {
+            extended.push_back(p - 1);
+            occurence |= stringOccurence[__builtin_ctz(textPositions[p - 1].speciesBit)];
+        }
+    }
+    return occurence;
+}
 
 // ============================================================================
 // SUFFIX TREE (PUBLIC FUNCTIONS)
@@ -832,20 +1380,24 @@ const std::vector<IupacMask> SuffixTree::exactAndAllDegenerateAlphabet ({
 
 
 SuffixTree::SuffixTree(const string& T, const string& name, bool hasReverseComplement, std::vector<size_t> stringStartPositions_, std::vector<std::string> gene_names_,
-std::vector<size_t> next_gene_locations_, std::vector<size_t> order_of_species_mapping_, MyMotifMap *motifmap_) : // tsl::sparse_map<long, blscounttype *> *motifmap_) :
-    T(T), name(name), reverseComplementFactor(hasReverseComplement ? 2 : 1), stringStartPositions(stringStartPositions_), gene_names(gene_names_), next_gene_locations(next_gene_locations_),
+std::vector<size_t> next_gene_locations_, std::vector<size_t> order_of_species_mapping_, MyMotifMap *motifmap_, const int constructionThreads) : // tsl::sparse_map<long, blscounttype *> *motifmap_) :
+    ownText(T), T(ownText), name(name), reverseComplementFactor(hasReverseComplement ? 2 : 1), stringStartPositions(stringStartPositions_), gene_names(gene_names_), next_gene_locations(next_gene_locations_),
     order_of_species_mapping(order_of_species_mapping_)
 {
         // assert(gene_names.size() + 1== next_gene_locations.size()); // locations has an extra -> 0 pos
         // for (size_t i = 0 ; i < stringStartPositions.size() - 1; i++) {
             // std::cerr << T.substr(stringStartPositions[i] , (stringStartPositions[i+1] - stringStartPositions[i])) << std::endl;
         // }
-        // maximum string length = 2^32-1
-        if (T.size() >= (size_t)numeric_limits<length_t>::max())
+        // maximum string length = 2^30-1, so the links between the (at most 2n) nodes fit in 32 bits
+        if (T.size() >= ((size_t)1 << 30))
                 throw runtime_error("String exceeds maximum length");
 
         // construct suffix tree using Ukonen's algorithm
-        constructUkonen();
+        if (constructionThreads > 1)
+                constructPartitioned(constructionThreads);
+        else
+                constructUkonen();
+        buildTextPositions();
         this->motifmap = motifmap_;
         // check if gene positions are correct
         // size_t start = 0, end = 0;
@@ -857,24 +1409,22 @@ std::vector<size_t> next_gene_locations_, std::vector<size_t> order_of_species_m
         // }
 }
 
-
-
-SuffixTree::~SuffixTree()
+SuffixTree::SuffixTree(std::string_view T, const string& name, bool hasReverseComplement, STNode* root, size_t nodeCount,
+  const TextPosition* textPositions, const length_t* leafSuffixes, std::vector<size_t> stringStartPositions_, std::vector<std::string> gene_names_,
+  std::vector<size_t> next_gene_locations_, std::vector<size_t> order_of_species_mapping_) :
+    T(T), name(name), root(root), reverseComplementFactor(hasReverseComplement ? 2 : 1), node_count(nodeCount),
+    stringStartPositions(stringStartPositions_), gene_names(gene_names_), next_gene_locations(next_gene_locations_),
+    order_of_species_mapping(order_of_species_mapping_), textPositions(textPositions), leafSuffixes(leafSuffixes)
 {
-        // Depth-first traversal of the tree
-        stack<STNode*> stack;
-        stack.push(root);
+}
 
-        while (!stack.empty()) {
-                STNode* node = stack.top();
-                stack.pop();
 
-                for (int i = 0; i < MAX_CHAR; i++)
-                        if (node->getChildNumber(i) != NULL)
-                                stack.push(node->getChildNumber(i));
 
-                delete node;
-        }
+SuffixTree::~SuffixTree()
+{
+        if (nodes.empty()) // mapped from a TreeIndex
+                return;
+        vector<STNode>().swap(nodes);
         malloc_trim(0); // this gives memory back to OS!
 }
 
@@ -883,14 +1433,6 @@ int SuffixTree::printMotifs(const std::pair<short, short>& l, const Alphabet alp
         if(alphabet == EXACT) {
             assert(maxDegenerateLetters == 0); // cannot have degenerate letters with exact alphabet
         }
-        if(alphabet == EXACT)
-            this->alphabet = &(this->exactAlphabet);
-        else if(alphabet == EXACTANDN)
-            this->alphabet = &(this->exactAndNAlphabet);
-        else if (alphabet == TWOFOLDSANDN)
-            this->alphabet = &(this->exactTwofoldAndNAlphabet);
-        else
-            this->alphabet = &(this->exactAndAllDegenerateAlphabet);
 
         STPositionsPerLetter positions(l.second, maxDegenerateLetters); // 13
 
@@ -902,19 +1444,47 @@ int SuffixTree::printMotifs(const std::pair<short, short>& l, const Alphabet alp
             // std::cerr << "pos: " << p.getPositionInText() << ": " <<  T.substr(p.getPositionInText() - p.getDepth(), iupacword.length()) << std::endl;
             // positions.list[iupacword.length()].addSTPosition(p.node, p.offset);
         // }
-        // recPrintMotifs(l, maxDegenerateLetters, bls, positions, iupacword, 1, out);
+        // enumerateMotifs(l, maxDegenerateLetters, bls, positions, iupacword, 1, out);
 // start from root
         motifCount = 0;
         iteratorCount = 0;
+        nodesVisited = 0;
+        positionsAdvanced = 0;
         positions.list[0].addSTPosition(root);
-        std::vector<std::pair<int, int>> stringPos;
-        if(isAlignmentBased)
-            recPrintMotifsWithPositions(l, maxDegenerateLetters, bls, positions, stringPos, "", 0, out);
+        // alignment based motifs are always printed
+        if(motifmap != NULL && !isAlignmentBased)
+            iterateMotifs<MapSink>(l, alphabet, maxDegenerateLetters, bls, positions, out, isAlignmentBased);
+        else if(!binaryOutput)
+            iterateMotifs<StringSink>(l, alphabet, maxDegenerateLetters, bls, positions, out, isAlignmentBased);
         else
-            recPrintMotifs(l, maxDegenerateLetters, bls, positions, "", 0, out);
+            iterateMotifs<BinarySink>(l, alphabet, maxDegenerateLetters, bls, positions, out, isAlignmentBased);
         return motifCount;
 }
 
+template<class Sink>
+void SuffixTree::iterateMotifs(const std::pair<short, short>& l, const Alphabet alphabet, const int& maxDegenerateLetters, const BLSScore& bls,
+  STPositionsPerLetter& positions, std::ostream& out, bool isAlignmentBased)
+{
+        if(isAlignmentBased) {
+            std::vector<size_t> stringPos;
+            stringPos.reserve(T.size()); // the root collects every position in the tree
+            LocationBuffers buffers;
+            switch(alphabet) {
+                case EXACT: enumerateMotifsWithPositions<EXACT, Sink>(l, maxDegenerateLetters, bls, positions, stringPos, buffers, out); break;
+                case EXACTANDN: enumerateMotifsWithPositions<EXACTANDN, Sink>(l, maxDegenerateLetters, bls, positions, stringPos, buffers, out); break;
+                case TWOFOLDSANDN: enumerateMotifsWithPositions<TWOFOLDSANDN, Sink>(l, maxDegenerateLetters, bls, positions, stringPos, buffers, out); break;
+                default: enumerateMotifsWithPositions<ALL, Sink>(l, maxDegenerateLetters, bls, positions, stringPos, buffers, out); break;
+            }
+        } else {
+            switch(alphabet) {
+                case EXACT: enumerateMotifs<EXACT, Sink>(l, maxDegenerateLetters, bls, positions, out); break;
+                case EXACTANDN: enumerateMotifs<EXACTANDN, Sink>(l, maxDegenerateLetters, bls, positions, out); break;
+                case TWOFOLDSANDN: enumerateMotifs<TWOFOLDSANDN, Sink>(l, maxDegenerateLetters, bls, positions, out); break;
+                default: enumerateMotifs<ALL, Sink>(l, maxDegenerateLetters, bls, positions, out); break;
+            }
+        }
+}
+
 
 void SuffixTree::matchPattern(const string& P, vector<size_t>& occ)
 {
@@ -946,15 +1516,20 @@ std::vector<std::pair<int, int>> SuffixTree::matchIupacPatternWithPositions(cons
             }
             i++;
         }
-        std::vector<std::pair<int, int>> stringPositions;
+        std::vector<size_t> suffixes;
         // std::cerr << "found " << positions.list[P.size()].validPositions << " valid positions" << std::endl;
         // for(size_t i = 0; i < positions.list[P.size()].validPositions; i++) {
         //     std::cerr << i << ": " << positions.list[P.size()].list[i].getPositionInText() << std::endl;
         // }
-        getLeafPositions(stringPositions, positions.list[P.size()].list, positions.list[P.size()].validPositions);
+        LocationBuffers buffers;
+        getLeafPositions(suffixes, positions.list[P.size()].list, positions.list[P.size()].validPositions, buffers);
         // getPositionsStartingWithFiller(stringPositions, positions.list[P.size()].list, positions.list[P.size()].validPositions);
-        getBestOccurence(stringPositions, bls, occurence); // best occurence according to the available positions
+        getBestOccurence(suffixes, bls, occurence); // best occurence according to the available positions
 
+        std::vector<std::pair<int, int>> stringPositions;
+        for(size_t p : suffixes) {
+            stringPositions.push_back(getStringPosition(p));
+        }
         return stringPositions;
 }
 
@@ -980,45 +1555,44 @@ std::vector<std::pair<int, int>> SuffixTree::matchIupacPattern(const string& P,
 }
 
 
-int SuffixTree::matchIupacPatterns(std::istream& in, std::ostream& out, const BLSScore& bls, const int &maxDegenerateLetters, const short& maxlen, const float& min_bls) {
-    std::string line, motif, lastmotif = "";
-    STPositionsPerLetter positions(maxlen, maxDegenerateLetters); // can be reused, if sorted order!
-    positions.list[0].addSTPosition(root);
-    size_t i =0;
-    occurence_bits occurence;
-    int blsThresholdIdx = 0, tabIdx = 0;
-
+int SuffixTree::matchIupacPatterns(std::istream& in, std::ostream& out, const BLSScore& bls, const int &maxDegenerateLetters, const float& min_bls) const {
     std::cerr << "min bls is " << min_bls << std::endl;
-    int count = 0;
-    std::getline(in, line);
-    while (!line.empty()) { // loop over motifs until empty line or line with - signaling the end
-        i = 0;
-        tabIdx = line.find_first_of('\t');
-        motif = line.substr(0, tabIdx);
-        blsThresholdIdx = std::stoi(line.substr(tabIdx + 1));
-        // std::cerr << motif << " @ " << blsThresholdIdx << std::endl;
-        // check how much it matches with last motif
-        while(motif[i] == lastmotif[i] && i < min(lastmotif.size(), motif.size()) ) {
-            i++;
+    MotifTrie trie;
+    int count = trie.readMotifs(in);
+    matchMotifTrie(trie, out, bls, maxDegenerateLetters, min_bls);
+    return count;
+}
+
+/**
+Walks the trie and the suffix tree together, in depth first order of the trie the positions of the parent prefix are always in positions.list[depth - 1].
+If a prefix has no positions left, the whole subtree of that trie node is skipped.
+*/
+void SuffixTree::matchMotifTrie(const MotifTrie& trie, std::ostream& out, const BLSScore& bls, const int &maxDegenerateLetters, const float& min_bls, const bool binaryPositions) const {
+    const size_t flushSize = 1 << 16;
+    LocationBuffers buffers;
+    STPositionsPerLetter positions(trie.getMaxDepth() + 1, std::max(maxDegenerateLetters, trie.getMaxDegenerateLetters()));
+    std::vector<occurence_bits> occurence(trie.getMaxDepth() + 1, 0);
+    positions.list[0].addSTPosition(root);
+    size_t n = 1;
+    while (n < trie.size()) {
+        const MotifTrieNode& node = trie.getNode(n);
+        advanceIupacCharacter(node.mask, node.depth - 1, positions, occurence[node.depth]);
+        if (positions.list[node.depth].empty()) {
+            n = node.subtreeEnd; // no motif with this prefix occurs
+            continue;
         }
-        // std::cerr << "reusing " << i << " positions" << std::endl;
-        while (!positions.list[i].empty() && i < motif.size()) {
-            // std::cerr << "i: " << i << " valid pos: " << positions.list[i].validPositions << std::endl;
-            advanceIupacCharacter(IupacMask::characterToMask[motif[i]], i, positions, occurence);
-            // std::cerr << "matching " << motif[i] << " has " << positions.list[i+1].validPositions << " locations and occurence " << occurence << std::endl;
-            // for(int j = 0; j < positions.list[i+1].validPositions; j++) {
-                // std::cerr << "pos: " << positions.list[i+1].list[j].getPositionInText() << ": " <<
-                // T.substr(positions.list[i+1].list[j].getPositionInText() - positions.list[i+1].list[j].getDepth(), i + 1) << std::endl;
-            // }
-            i++;
+        for (size_t q = node.firstQuery; q < node.lastQuery; q++) {
+            const MotifQuery& query = trie.getQuery(q);
+            if(bls.greaterThanThreshold(occurence[node.depth], query.blsThresholdIdx) && bls.getBLSScore(occurence[node.depth]) > min_bls)
+                getLeafPositionsAndPrint(positions.list[node.depth].list, positions.list[node.depth].validPositions, buffers, query.motif, bls.getBLSScore(occurence[node.depth]), binaryPositions);
+        }
+        if (buffers.output.size() > flushSize) {
+            out.write(buffers.output.data(), buffers.output.size());
+            buffers.output.clear();
         }
-        if(positions.list[motif.size()].validPositions > 0 && bls.greaterThanThreshold(occurence, blsThresholdIdx) && bls.getBLSScore(occurence) > min_bls)
-            getLeafPositionsAndPrint(positions.list[motif.size()].list, positions.list[motif.size()].validPositions, out, motif, bls.getBLSScore(occurence));
-        lastmotif = motif;
-        count++;
-        std::getline(in, line);
+        n++;
     }
-    return count;
+    out.write(buffers.output.data(), buffers.output.size());
 }
 
 void SuffixTree::matchPattern(const string& P, BLSScore& bls)
@@ -1040,15 +1614,12 @@ void SuffixTree::findMEM(const string& Q, size_t minSize, vector<MEMOcc>& occ)
         // clear the occurrence vector
         occ.clear();
 
-        STPosition pos(root);
+        // the suffix links are dropped once the tree is built, so every suffix of Q is matched from the root
         for (size_t j = 0; j < Q.size(); j++) {
-
-                // advance posMax as much as possible
-                advancePos(pos, Q, j+pos.getDepth(), Q.size());
+                STPosition pos(root);
+                advancePos(pos, Q, j, Q.size());
 
                 if (pos.getDepth() >= minSize)
                         reportMEM(Q, j, minSize, pos, occ);
-
-                pos = followSuffixLink(pos);
         }
 }
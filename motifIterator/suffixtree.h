@@ -23,11 +23,14 @@
 #include <tuple>
 #include <limits>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <cstdint>
 #include <unordered_set>
 #include <cassert>
 #include "motif.h"
 #include "motifmap.h"
+#include "motiftrie.h"
 
 // ============================================================================
 // (TYPE) DEFINITIONS AND PROTOTYPES
@@ -41,6 +44,17 @@ typedef std::tuple<size_t, size_t, size_t> MEMOcc;
 
 enum Alphabet { EXACT = 0x0, EXACTANDN = 0x1, TWOFOLDSANDN = 0x2, ALL = 0x3 };
 
+// every alphabet is a prefix of this list: the exact bases, N, the twofold and the threefold degenerate letters
+static constexpr IupacMask extensionList[] = {
+    IupacMask(BASE_A), IupacMask(BASE_C), IupacMask(BASE_G), IupacMask(BASE_T),
+    IupacMask(IUPAC_N),
+    IupacMask(IUPAC_R), IupacMask(IUPAC_Y), IupacMask(IUPAC_S), IupacMask(IUPAC_W), IupacMask(IUPAC_K), IupacMask(IUPAC_M),
+    IupacMask(IUPAC_V), IupacMask(IUPAC_H), IupacMask(IUPAC_D), IupacMask(IUPAC_B)
+};
+static constexpr int exactExtensions = 4; // only these are tried once the maximum number of degenerate letters is reached
+template<Alphabet A>
+static constexpr int extensionCount = A == EXACT ? 4 : A == EXACTANDN ? 5 : A == TWOFOLDSANDN ? 11 : 15;
+
 struct MotifPosition {
   int family;
   int gene;
@@ -57,9 +71,11 @@ struct MotifPosition {
 // CLASS SUFFIX TREE NODE
 // ============================================================================
 
-// A suffix tree node contains links to its parent and children, a suffix link,
-// the depth of the node and a suffix index in case it is a leaf node.
+// A suffix tree node contains links to its children, the depth of the node
+// and a suffix index in case it is a leaf node.
 // For non-leaf nodes, the suffix index contains the length_t::max() value.
+// The parent and suffix link are only needed to build the tree, they are kept
+// apart from the nodes by the SuffixTree (see STNodeLinks).
 
 // A suffix tree node also contains a range [beginIdx, endIdx[ in T of its
 // parent edge. The range encodes the characters implied on the edge.
@@ -70,17 +86,28 @@ private:
         length_t beginIdx;              // begin index in T of parent edge
         length_t endIdx;                // end index in T of parent edge
 
-        // node properties
-        STNode* parent;                 // pointer to the parent (NULL for root)
-        STNode* child[MAX_CHAR];        // pointers to children
-        STNode* suffixLink;             // points to suffix link node
+        // node properties, the nodes of a tree are in one block and links are stored as the distance in nodes
+        // from this node (0 for NULL), so a block that is moved, copied or memory mapped as a whole stays valid, see TreeIndex
+        int32_t child[MAX_CHAR];        // links to children
         length_t depth;                 // depth of current node
         length_t suffixIdx;             // suffix index (only for leaf nodes)
+        length_t firstLeaf;             // the leaves under this node are [firstLeaf, lastLeaf[ in depth first order
+        length_t lastLeaf;
         occurence_bits occurence;
         static const std::vector<char> Alphabet;
         // static const std::vector<short> charToIndex;
         static const short charToIndex[MAX_ASCII_CHAR];
 
+        // integer arithmetic, a mapped block is not an array of the compiler
+        STNode* follow(const int32_t link) const {
+                return link == 0 ? NULL : reinterpret_cast<STNode*>(reinterpret_cast<uintptr_t>(this) + (intptr_t)link * (intptr_t)sizeof(STNode));
+        }
+        int32_t linkTo(const STNode* node) const {
+                return node == NULL ? 0 : (int32_t)((intptr_t)(reinterpret_cast<uintptr_t>(node) - reinterpret_cast<uintptr_t>(this)) / (intptr_t)sizeof(STNode));
+        }
+
+        friend class SuffixTree;        // relayout rewrites the links
+
 public:
         /**
          * Constructor
@@ -88,24 +115,20 @@ public:
          * @param end End index in T
          */
         STNode(length_t begin, length_t end) : beginIdx(begin), endIdx(end), occurence(0) {
-                parent = NULL;
                 for (int i = 0; i < MAX_CHAR; i++)
-                        child[i] = NULL;
-                suffixLink = NULL;
+                        child[i] = 0;
                 depth = end - begin;
                 suffixIdx = std::numeric_limits<length_t>::max();
+                firstLeaf = lastLeaf = 0;
         }
 
 
         /**
-         * Sets the bit for string number 'occurenceBit' to true in a GST
+         * Sets the bit for string number 'occurenceBit' to true in a GST, the parents get it in SuffixTree::annotateSubtree
          * @return occurenceBit is the number of the current string this suffix belongs to
          */
         void setOccurenceBitForGST(unsigned char occurenceBit) { // used in leaf
-            occurence |= 1 << (occurenceBit ); // divide by 2 to take into account Reverse complement!
-            if(parent != NULL && !(parent->occurence &  (1 << (occurenceBit )) ) ) { // if parent and parent hasnt got this occurence set it!
-              parent->setOccurenceBitForGST(occurenceBit);
-            }
+            occurence |= 1 << (occurenceBit );
         }
         void setOccurence(occurence_bits occurence_) {
             occurence = occurence_;
@@ -154,24 +177,16 @@ public:
                 return endIdx - beginIdx;
         }
 
-        /**
-         * Get the parent node
-         * @return The parent node
-         */
-        STNode* getParent() const {
-                return parent;
-        }
-
         /**
          * Get a pointer to child node for which the edge starts with c
          * @param c Character c
          */
         STNode* getChild(char c) const {
-                return child[charToIndex[static_cast<unsigned char>(c)]];
+                return follow(child[charToIndex[static_cast<unsigned char>(c)]]);
                 // return child[static_cast<unsigned char>(c)];
         }
         STNode* getChildNumber(unsigned char i) const {
-                return child[i];
+                return follow(child[i]);
         }
 
         /**
@@ -180,28 +195,11 @@ public:
          * @param chdToAdd Pointer to the child
          */
         void setChild(char c, STNode* chdToAdd) {
-                chdToAdd->parent = this;
                 chdToAdd->depth = depth + chdToAdd->getEdgeLength();
-                child[charToIndex[static_cast<unsigned char>(c)]] = chdToAdd;
+                child[charToIndex[static_cast<unsigned char>(c)]] = linkTo(chdToAdd);
                 // child[static_cast<unsigned char>(c)] = chdToAdd;
         }
 
-        /**
-         * Set the suffix link (for internal nodes only)
-         * @param target Target value
-         */
-        void setSuffixLink(STNode* target) {
-                suffixLink = target;
-        }
-
-        /**
-         * Get the suffix link from this node (only for internal nodes)
-         * @return suffix link
-         */
-        STNode* getSuffixLink() const {
-                return suffixLink;
-        }
-
         /**
          * Set the suffix index (for leaves only)
          * @param target Target value
@@ -234,6 +232,22 @@ public:
                 return depth;
         }
 
+        /**
+         * Set the range of the leaves under this node, in the depth first order of SuffixTree::leafSuffixes
+         * @param first First leaf
+         * @param last One past the last leaf
+         */
+        void setLeafRange(length_t first, length_t last) {
+                firstLeaf = first;
+                lastLeaf = last;
+        }
+        length_t getFirstLeaf() const {
+                return firstLeaf;
+        }
+        length_t getLastLeaf() const {
+                return lastLeaf;
+        }
+
         /**
          * Check whether the node is a leaf
          * @return true or false
@@ -297,7 +311,7 @@ public:
         }
 
         size_t getPositionInText() const {
-          return node->getParent() == NULL ? -1 : node->begin() + offset; // -1 for root node, else position in string
+          return node->getDepth() == 0 ? -1 : node->begin() + offset; // -1 for root node, else position in string
         }
         /**
          * Get the depth of the position
@@ -371,15 +385,57 @@ public:
   }
 };
 
+// where a position of T lies in the input, so a leaf in alignment based mode is resolved with a single lookup
+struct TextPosition {
+  uint32_t column : 31;               // position in its string, i.e. the alignment column
+  uint32_t reverseComplement : 1;     // position is on the reverse complement string
+  occurence_bits speciesBit;          // bit of the species in the order of the strings
+};
+
+// reusable buffers to locate motifs, every thread that locates motifs has its own
+struct LocationBuffers {
+  std::vector<size_t> occ;            // suffix indices of the current motif
+  std::string output;                 // formatted output, written to the stream in large chunks
+  // occurence of the motif and its reverse complement per alignment column, indexed by the position in the string
+  std::vector<occurence_bits> columnOcc;
+  std::vector<occurence_bits> columnRcOcc;
+  std::vector<uint32_t> columns;      // columns with a non empty occurence, in order of first use
+};
+
+// links of a node that are only needed while the tree is built, by node index, they are dropped afterwards
+struct STNodeLinks {
+  static const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+  uint32_t parent = NONE;             // NONE for the root
+  uint32_t suffixLink = NONE;         // NONE if not set (yet)
+};
+
+// state of one depth of the motif enumeration, which keeps a frame per motif character instead of recursing
+struct EnumerationFrame {
+  int next;                           // next extension to try
+  int extensions;                     // number of extensions of this prefix
+  int degenerateLetters;              // degenerate letters in the prefix
+  bool degenerate;                    // the current extension is degenerate
+  size_t start;                       // alignment based: first position of the current extension in the position list
+  size_t validChildren;               // alignment based: positions of the exact extensions
+  occurence_bits reverseComplementOccurence; // forward strand index: occurence of the reverse complement of the prefix
+  bool reverseComplementListed;       // forward strand index: the start positions of the reverse complement of the prefix are listed
+  GroupBalance balance;               // of the prefix, to skip the branches without group representatives
+};
+
 // ============================================================================
 // CLASS SUFFIX TREE
 // ============================================================================
 
 class SuffixTree;
-typedef void (SuffixTree::*printMotifPtr)(const short& maxlen, const std::string& currentMotif, const BLSScore& bls, const occurence_bits& occurence, std::ostream& out);
+struct SuffixTreeBenchmark;
+struct SuffixTreeTestAccess;
 
 class SuffixTree {
 
+        friend struct SuffixTreeBenchmark; // the microbenchmarks time the private kernels
+        friend struct SuffixTreeTestAccess; // the gtests check the private kernels against a scan of T
+        friend class TreeIndex;            // writes and maps the built tree
+
 private:
         // --------------------------------------------------------------------
         // ROUTINES TO MANIPULATE SUFFIX TREE POSITIONS
@@ -403,7 +459,7 @@ private:
          * @param end End position in str to match
          * @return true if pattern is fully matched, false otherwise
          */
-        bool advancePos(STPosition& pos, const std::string& P,
+        bool advancePos(STPosition& pos, std::string_view P,
                         size_t begin, size_t end) const;
 
         /**
@@ -413,7 +469,7 @@ private:
          * @param begin First position in str to match
          * @param end End position in str to match
          */
-        void advancePosSkipCount(STPosition& pos, const std::string& P,
+        void advancePosSkipCount(STPosition& pos, std::string_view P,
                                  size_t begin, size_t end) const;
 
         /**
@@ -435,9 +491,9 @@ private:
         // --------------------------------------------------------------------
 
         /**
-         * Get all occurrences under a given position
+         * Get all occurrences under a given position, the leaves are a contiguous range in depth first order
          * @param node Pointer to a node
-         * @param occ Vector to store the occurrences (output)
+         * @param occ Vector to append the occurrences to (output)
          */
         void getOccurrences(const STPosition& pos, std::vector<size_t>& occ) const;
 
@@ -456,6 +512,24 @@ private:
         // ROUTINES TO CONSTRUCT/MANIPULATE SUFFIX TREE
         // --------------------------------------------------------------------
 
+        /**
+         * Add a node to the block of nodes, which has room for every node of the tree
+         * @param begin Begin index in T
+         * @param end End index in T
+         * @return The new node
+         */
+        STNode* newNode(length_t begin, length_t end);
+        size_t nodeIndex(const STNode* node) const {
+                return node - nodes.data();
+        }
+
+        // construction only, see STNodeLinks
+        STNode* getParent(const STNode* node) const;
+        STNode* getSuffixLink(const STNode* node) const;
+        void setSuffixLink(STNode* node, STNode* target);
+        // sets the child of node and the parent of chd
+        void setChild(STNode* node, char c, STNode* chd);
+
         /**
          * Given a suffix tree position, split the edge
          * @param pos Suffix tree position
@@ -503,6 +577,45 @@ private:
          */
         void constructUkonen();
 
+        /**
+         * Construct the suffix tree on several threads: the suffixes are partitioned by their first two characters,
+         * the sub-tree of every partition is built on its own and they are attached under the root.
+         * The suffix array and LCP array of T are built first (in linear time, on one thread), every partition is a
+         * range of the suffix array, so a sub-tree takes time linear in its number of suffixes, also for repeats.
+         * The tree is the same as the one of constructUkonen
+         * @param threads Number of threads
+         */
+        void constructPartitioned(const int threads);
+
+        /**
+         * Builds the sub-tree of a range of the suffix array, suffixes that are a prefix of another one get no leaf
+         * @param SA Suffix array of T
+         * @param LCP LCP[k] is the length of the longest common prefix of the suffixes SA[k-1] and SA[k]
+         * @param first First suffix of the partition in SA
+         * @param last One past the last suffix of the partition in SA
+         * @param block Nodes of the sub-tree (output), the first one stands for the root
+         */
+        void buildPartition(const std::vector<int>& SA, const std::vector<int>& LCP, const size_t first, const size_t last,
+                            std::vector<STNode>& block) const;
+
+        /**
+         * The occurence bit of the species of a suffix, as constructUkonen sets it
+         */
+        unsigned char getLeafBit(const size_t suffixIndex) const;
+
+        /**
+         * Sets the occurence of every internal node in a subtree to the union of its leaves and numbers the leaves
+         * in depth first order, in one post-order pass. The leaves are appended to ownLeafSuffixes
+         * @param subtree Root of the subtree
+         * @return The occurence of the subtree
+         */
+        occurence_bits annotateSubtree(STNode* subtree);
+
+        /**
+         * Annotates the subtrees of the root after the tree is built, see annotateSubtree
+         */
+        void annotateTree();
+
         // --------------------------------------------------------------------
         // ROUTINES FOR I/O
         // --------------------------------------------------------------------
@@ -515,54 +628,74 @@ private:
         std::ostream& write(std::ostream& o) const;
 
         // --------------------------------------------------------------------
-        const std::string T;            // text to index
+        const std::string ownText;      // the text of a tree that is built, empty if the tree is mapped from a TreeIndex
+        const std::string_view T;       // text to index
         const std::string name;            // text to index
         STNode* root;                   // pointer to the root node
-        static const std::vector<IupacMask> exactAlphabet;
-        static const std::vector<IupacMask> exactAndNAlphabet;
-        static const std::vector<IupacMask> exactTwofoldAndNAlphabet;
-        static const std::vector<IupacMask> exactAndAllDegenerateAlphabet;
-        const std::vector<IupacMask> *alphabet;
+        std::vector<STNode> nodes;      // the nodes in one block with the root first, empty if they are mapped from a TreeIndex
+        std::vector<STNodeLinks> constructionLinks; // per node in the block, only while the tree is built
         int reverseComplementFactor = 1;
         int motifCount;
         size_t iteratorCount;
+        size_t nodesVisited = 0;        // calls of the motif recursion
+        size_t positionsAdvanced = 0;   // suffix tree positions extended by the motif recursion
         size_t node_count = 0;
         std::vector<size_t> stringStartPositions; // indicates where new strings start
         std::vector<std::string> gene_names; // identify gene names
         std::vector<size_t> next_gene_locations; // identify genes
         std::vector<size_t> order_of_species_mapping; // map species to correct index in the bls tree
+        std::vector<TextPosition> ownTextPositions;
+        const TextPosition* textPositions; // string and column of every position in T, built at construction or mapped
+        std::vector<length_t> ownLeafSuffixes;
+        const length_t* leafSuffixes;   // suffix index of every leaf in depth first order, built at construction or mapped
         MyMotifMap *motifmap = NULL;
         // --------------------------------------------------------------------
 
-        void recPrintMotifs(const std::pair<short, short>& l,
+        // the motif enumerators are instantiated per alphabet (the extensions are known at compile time)
+        // and per Sink, the struct whose static emit handles a valid motif: BinarySink, StringSink or MapSink
+        struct BinarySink;
+        struct StringSink;
+        struct MapSink;
+        template<Alphabet A, class Sink>
+        void enumerateMotifs(const std::pair<short, short>& l,
           const int& maxDegenerateLetters, const BLSScore& bls,
-          STPositionsPerLetter& matchingNodes, const std::string& prefix,
-          int curDegenerateLetters, std::ostream& out);
-        // this next one also returns all positions the current Motif matches
-        void recPrintMotifsWithPositions(const std::pair<short, short>& l,
+          STPositionsPerLetter& matchingNodes, std::ostream& out);
+        // this next one also appends the suffix indices of all positions the current Motif matches to stringPositions
+        // the positions of every extension are appended behind those of the previous extensions, so one buffer is reused for the whole enumeration
+        template<Alphabet A, class Sink>
+        void enumerateMotifsWithPositions(const std::pair<short, short>& l,
           const int& maxDegenerateLetters, const BLSScore& bls,
-          STPositionsPerLetter& matchingNodes, std::vector<std::pair<int, int>>& stringPositions, const std::string& prefix,
-          int curDegenerateLetters, std::ostream& out);
-
+          STPositionsPerLetter& matchingNodes, std::vector<size_t>& stringPositions, LocationBuffers& buffers, std::ostream& out);
+        template<class Sink>
+        void iterateMotifs(const std::pair<short, short>& l, const Alphabet alphabet, const int& maxDegenerateLetters, const BLSScore& bls,
+          STPositionsPerLetter& positions, std::ostream& out, bool isAlignmentBased);
+
+        void buildTextPositions();
+        // <# of string, pos in that string> of a suffix index
+        std::pair<int, int> getStringPosition(const size_t p) const;
         void getLeafPositions(std::vector<std::pair<int, int>>& positions, const std::vector<STPosition>& nodePositions, const size_t size) const;
-        void getPositionsStartingWithDelimiter(std::vector<std::pair<int, int>>& positions, const std::vector<STPosition>& nodePositions, const size_t size) const;
+        void getLeafPositions(std::vector<size_t>& positions, const std::vector<STPosition>& nodePositions, const size_t size, LocationBuffers& buffers) const;
+        void getPositionsStartingWithDelimiter(std::vector<size_t>& positions, const std::vector<STPosition>& nodePositions, const size_t size, LocationBuffers& buffers) const;
 
         void advanceIupacCharacter(const IupacMask& mask, const int& characterPos, STPositionsPerLetter& matchingNodes, occurence_bits& occurence) const;
         void advanceExactCharacter(const IupacMask& mask, const int& characterPos, STPositionsPerLetter& matchingNodes, occurence_bits& occurence) const;
-        void getBestOccurence(std::vector<std::pair<int, int>>& positions, const BLSScore& bls, occurence_bits& occurence);
+        // the occurence of the reverse complement of motif, matched from the root, positions.list[0] holds the root
+        occurence_bits getReverseComplementOccurence(const std::string& motif, STPositionsPerLetter& positions) const;
+        // the start positions in T of the leaves under the matched positions, false if there are more than maxStarts
+        bool listStartPositions(const STPositionVector& positions, const size_t maxStarts, std::vector<length_t>& starts) const;
+        // the start positions of the string preceded by a base of mask, from those of the string, with the occurence of the new ones
+        occurence_bits prependCharacter(const unsigned char mask, const std::vector<length_t>& starts, const std::vector<occurence_bits>& stringOccurence,
+                                        std::vector<length_t>& extended) const;
+        void getBestOccurence(const std::vector<size_t>& positions, const BLSScore& bls, occurence_bits& occurence);
+        // only uses the positions [start, positions.size()[, the positions are grouped per column without sorting them
+        void getBestOccurence(const std::vector<size_t>& positions, const size_t start, const BLSScore& bls, occurence_bits& occurence, LocationBuffers& buffers);
 
         void printMotifBinary(const short& maxlen, const std::string& currentMotif, const BLSScore& bls, const occurence_bits& occurence, std::ostream& out);
         void printMotifString(const short& maxlen, const std::string& currentMotif, const BLSScore& bls, const occurence_bits& occurence, std::ostream& out);
 
         void addMotifToMap(const short& maxlen, const std::string& currentMotif, const BLSScore& bls, const occurence_bits& occurence);
 
-        printMotifPtr printMotif = &SuffixTree::printMotifBinary;
-        // printMotifPtr printMotif = &SuffixTree::printMotifString;
-
-        static bool positionPairSort(const std::pair<int,int> &a,  const std::pair<int,int> &b)
-        {
-            return a.second < b.second;
-        }
+        bool binaryOutput = true; // false writes the motifs with printMotifString, to read the output while debugging
 
 public:
         /**
@@ -572,8 +705,14 @@ public:
         // SuffixTree(const std::string& T) : SuffixTree(T, false) {}
         // SuffixTree(const std::string& T, bool hasReverseComplement);
         SuffixTree(const std::string& T, const std::string& name, bool hasReverseComplement, std::vector<size_t> stringStartPositions_, std::vector<std::string> gene_names_,
-          std::vector<size_t> next_gene_locations_, std::vector<size_t> order_of_species_mapping_, MyMotifMap *motifmap_);
-        //
+          std::vector<size_t> next_gene_locations_, std::vector<size_t> order_of_species_mapping_, MyMotifMap *motifmap_,
+          const int constructionThreads = 1);
+        /**
+         * Constructor for a tree that is mapped from a TreeIndex, the nodes and tables are used in place
+         */
+        SuffixTree(std::string_view T, const std::string& name, bool hasReverseComplement, STNode* root, size_t nodeCount,
+          const TextPosition* textPositions, const length_t* leafSuffixes, std::vector<size_t> stringStartPositions_, std::vector<std::string> gene_names_,
+          std::vector<size_t> next_gene_locations_, std::vector<size_t> order_of_species_mapping_);
 
         /**
          * Destructor
@@ -589,13 +728,31 @@ public:
         std::vector<std::pair<int, int>> matchIupacPattern(const std::string& P, const BLSScore& bls, int maxDegenerateLetters, occurence_bits& occurence);
         std::vector<std::pair<int, int>> matchIupacPatternWithPositions(const std::string& P, const BLSScore& bls, int maxDegenerateLetters, occurence_bits& occurence);
 
-        int matchIupacPatterns(std::istream& in, std::ostream& out, const BLSScore& bls, const int &maxDegenerateLetters, const short& maxlen, const float& min_bls);
+        int matchIupacPatterns(std::istream& in, std::ostream& out, const BLSScore& bls, const int &maxDegenerateLetters, const float& min_bls) const;
+        /**
+         * Locate all motifs of a query batch, shared prefixes in the trie are matched only once
+         * Motifs are written in sorted order
+         */
+        void matchMotifTrie(const MotifTrie& trie, std::ostream& out, const BLSScore& bls, const int &maxDegenerateLetters, const float& min_bls, const bool binaryPositions = false) const;
         // TODO add same but with positions
         void matchPattern(const std::string& P, BLSScore& bls);
         void printMotifPositions(std::ostream& out, const std::string &motif, std::vector<std::pair<int, int>> positions, const float blsScore);
+        /**
+         * Appends the motif with all its positions (gene@strand position) to buffers.output
+         * In binary format a record is: motif length (1 byte), motif, bls score (float), number of positions (uint32)
+         * followed by a (gene index << 1 | reverse complement, position in gene) uint32 pair per position
+         */
         void getLeafPositionsAndPrint(const std::vector<STPosition>& matchingNodes, const size_t size,
-          std::ostream& out, const std::string &motif, const float blsScore) const;
+          LocationBuffers& buffers, const std::string &motif, const float blsScore, const bool binaryPositions) const;
+        /**
+         * Writes the family name and the gene names the gene indexes of the binary position format refer to
+         * as uint32 length + characters, the gene names are preceded by their count (uint32)
+         */
+        void writeGeneTable(std::ostream& out) const;
         size_t getMotifsIteratedCount() { return iteratorCount; }
+        size_t getNodesVisitedCount() { return nodesVisited; }
+        size_t getPositionsAdvancedCount() { return positionsAdvanced; }
+        size_t getNodeCount() { return node_count; }
 
 
         /**
@@ -617,6 +774,13 @@ public:
                 return t.write(o);
         }
 
+        /**
+         * Reorders the block of nodes: the top levels breadth first, so the nodes every motif passes are close
+         * together, and the subtrees below them depth first. The links are rewritten, the tree is unchanged otherwise
+         * @param levels Levels below the root that are laid out breadth first, 0 for a depth first layout
+         */
+        void relayout(const int levels);
+
         /**
         * Find all motifs in the Suffix tree of length l
         * @Param l Length of motifs to find
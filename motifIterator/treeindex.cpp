@@ -0,0 +1,179 @@
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "treeindex.h"
+
+static const char indexMagic[8] = {'M', 'I', 'T', 'I', 'D', 'X', '0', '3'};
+
+// every section of a record starts at a multiple of 8 bytes, so the nodes are aligned in the mapping
+static size_t padded(const size_t bytes) {
+    return (bytes + 7) & ~(size_t)7;
+}
+
+static void writePadding(std::ostream& out, const size_t bytes) {
+    static const char zeros[8] = {};
+    out.write(zeros, padded(bytes) - bytes);
+}
+
+template<typename T>
+static void writeValue(std::ostream& out, const T value) {
+    out.write((const char*)&value, sizeof(T));
+}
+
+// sizes of one record, the counts are the lengths of the tables at the end
+struct IndexRecordHeader {
+    uint64_t recordSize;
+    uint64_t nameLength;
+    uint64_t textLength;
+    uint64_t nodeCount;
+    uint64_t leafCount;
+    uint64_t reverseComplementFactor;
+    uint64_t stringCount;
+    uint64_t geneCount;
+    uint64_t geneLocationCount;
+    uint64_t speciesCount;
+};
+
+void TreeIndex::writeHeader(std::ostream& out) {
+    out.write(indexMagic, sizeof(indexMagic));
+    writeValue<uint32_t>(out, sizeof(STNode));
+    writeValue<uint32_t>(out, sizeof(TextPosition));
+}
+
+void TreeIndex::write(std::ostream& out, const SuffixTree& tree) {
+    size_t geneBytes = 0;
+    for (const std::string& gene : tree.gene_names)
+        geneBytes += sizeof(uint64_t) + gene.size();
+    IndexRecordHeader header;
+    header.nameLength = tree.name.size();
+    header.textLength = tree.T.size();
+    header.nodeCount = tree.node_count;
+    header.leafCount = tree.root->getLastLeaf();
+    header.reverseComplementFactor = tree.reverseComplementFactor;
+    header.stringCount = tree.stringStartPositions.size();
+    header.geneCount = tree.gene_names.size();
+    header.geneLocationCount = tree.next_gene_locations.size();
+    header.speciesCount = tree.order_of_species_mapping.size();
+    header.recordSize = sizeof(IndexRecordHeader) + padded(header.nameLength) + padded(header.textLength)
+        + header.nodeCount * sizeof(STNode) + padded((header.textLength + 1) * sizeof(TextPosition)) + padded(header.leafCount * sizeof(length_t))
+        + sizeof(uint64_t) * (header.stringCount + header.geneLocationCount + header.speciesCount) + padded(geneBytes);
+    out.write((const char*)&header, sizeof(header));
+    out.write(tree.name.data(), tree.name.size());
+    writePadding(out, tree.name.size());
+    out.write(tree.T.data(), tree.T.size());
+    writePadding(out, tree.T.size());
+
+    // the links are relative within the block of nodes, which starts with the root
+    out.write((const char*)tree.root, header.nodeCount * sizeof(STNode));
+    out.write((const char*)tree.textPositions, (header.textLength + 1) * sizeof(TextPosition));
+    writePadding(out, (header.textLength + 1) * sizeof(TextPosition));
+    out.write((const char*)tree.leafSuffixes, header.leafCount * sizeof(length_t));
+    writePadding(out, header.leafCount * sizeof(length_t));
+
+    for (size_t p : tree.stringStartPositions)
+        writeValue<uint64_t>(out, p);
+    for (size_t p : tree.next_gene_locations)
+        writeValue<uint64_t>(out, p);
+    for (size_t s : tree.order_of_species_mapping)
+        writeValue<uint64_t>(out, s);
+    for (const std::string& gene : tree.gene_names) {
+        writeValue<uint64_t>(out, gene.size());
+        out.write(gene.data(), gene.size());
+    }
+    writePadding(out, geneBytes);
+}
+
+TreeIndex::TreeIndex(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::cerr << "cannot open tree index " << filename << std::endl;
+        if (fd >= 0) close(fd);
+        return;
+    }
+    size = st.st_size;
+    void* mapping = size > 0 ? mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "cannot map tree index " << filename << std::endl;
+        size = 0;
+        return;
+    }
+    const size_t fileHeaderSize = sizeof(indexMagic) + 2 * sizeof(uint32_t);
+    const char* file = (const char*)mapping;
+    if (size < fileHeaderSize || memcmp(file, indexMagic, sizeof(indexMagic)) != 0
+        || *(const uint32_t*)(file + 8) != sizeof(STNode) || *(const uint32_t*)(file + 12) != sizeof(TextPosition)) {
+        std::cerr << "tree index " << filename << " was not written by this version" << std::endl;
+        munmap(mapping, size);
+        size = 0;
+        return;
+    }
+    data = file;
+    // only the record headers are read here, the trees are paged in when they are used
+    size_t offset = fileHeaderSize;
+    while (offset + sizeof(IndexRecordHeader) <= size) {
+        const IndexRecordHeader* header = (const IndexRecordHeader*)(data + offset);
+        if (header->recordSize < sizeof(IndexRecordHeader) || offset + header->recordSize > size) {
+            std::cerr << "tree index " << filename << " is truncated after " << records.size() << " families" << std::endl;
+            break;
+        }
+        records[std::string(data + offset + sizeof(IndexRecordHeader), header->nameLength)] = offset;
+        offset += header->recordSize;
+    }
+}
+
+TreeIndex::~TreeIndex() {
+    if (data != NULL)
+        munmap((void*)data, size);
+}
+
+SuffixTree* TreeIndex::map(const std::string& name, const std::string& T, const std::vector<size_t>& order_of_species_mapping,
+    const std::vector<std::string>& gene_names) const {
+    auto it = records.find(name);
+    if (it == records.end())
+        return NULL;
+    const char* record = data + it->second;
+    const IndexRecordHeader& header = *(const IndexRecordHeader*)record;
+    const char* p = record + sizeof(IndexRecordHeader) + padded(header.nameLength);
+    std::string_view text(p, header.textLength);
+    if (text != T) {
+        std::cerr << "[" << name << "] the tree index holds another text, building the suffix tree" << std::endl;
+        return NULL;
+    }
+    p += padded(header.textLength);
+    STNode* root = (STNode*)p;
+    p += header.nodeCount * sizeof(STNode);
+    const TextPosition* textPositions = (const TextPosition*)p;
+    p += padded((header.textLength + 1) * sizeof(TextPosition));
+    const length_t* leafSuffixes = (const length_t*)p;
+    p += padded(header.leafCount * sizeof(length_t));
+
+    const uint64_t* values = (const uint64_t*)p;
+    std::vector<size_t> stringStartPositions(values, values + header.stringCount);
+    values += header.stringCount;
+    std::vector<size_t> next_gene_locations(values, values + header.geneLocationCount);
+    values += header.geneLocationCount;
+    // a tree indexed with another species tree numbers the species differently, its occurences would be scored wrong
+    if (header.speciesCount != order_of_species_mapping.size()
+        || !std::equal(order_of_species_mapping.begin(), order_of_species_mapping.end(), values)) {
+        std::cerr << "[" << name << "] the tree index was built with another species order, building the suffix tree" << std::endl;
+        return NULL;
+    }
+    values += header.speciesCount;
+    p = (const char*)values;
+    bool sameGenes = header.geneCount == gene_names.size();
+    for (size_t g = 0; sameGenes && g < gene_names.size(); g++) {
+        uint64_t length = *(const uint64_t*)p;
+        sameGenes = std::string_view(p + sizeof(uint64_t), length) == gene_names[g];
+        p += sizeof(uint64_t) + length;
+    }
+    if (!sameGenes) {
+        std::cerr << "[" << name << "] the tree index holds other gene names, building the suffix tree" << std::endl;
+        return NULL;
+    }
+    return new SuffixTree(text, name, header.reverseComplementFactor == 2, root, header.nodeCount, textPositions, leafSuffixes,
+        stringStartPositions, gene_names, next_gene_locations, order_of_species_mapping);
+}
@@ -0,0 +1,48 @@
+#ifndef TREEINDEX_H
+#define TREEINDEX_H
+
+#include <string>
+#include <iostream>
+#include <unordered_map>
+#include "suffixtree.h"
+
+/**
+ * File with the built suffix trees of many families, so repeated location runs do not rebuild them.
+ * A tree is stored as it is in memory: its name and T, the block of nodes (with their relative links) with the root
+ * first, the text positions, the leaves in depth first order and the gene and string tables. The file is memory mapped read only and the
+ * trees are used in place, so opening it is fast and concurrent runs share the page cache.
+ * The file only works on machines with the same node layout, which is checked when it is opened.
+ */
+class TreeIndex {
+private:
+    const char* data = NULL;
+    size_t size = 0;
+    std::unordered_map<std::string, size_t> records; // family name -> offset of its record
+
+public:
+    /**
+     * Maps an index file, isOpen() is false if the file cannot be mapped or was written with another node layout
+     */
+    TreeIndex(const std::string& filename);
+    ~TreeIndex();
+    TreeIndex(const TreeIndex&) = delete;
+    TreeIndex& operator=(const TreeIndex&) = delete;
+
+    bool isOpen() const { return data != NULL; }
+    size_t familyCount() const { return records.size(); }
+
+    /**
+     * The tree of the family with this name, if it was built from exactly the same text, species order and genes
+     * @return NULL if the family is not in the index or was indexed from other input
+     */
+    SuffixTree* map(const std::string& name, const std::string& T, const std::vector<size_t>& order_of_species_mapping,
+        const std::vector<std::string>& gene_names) const;
+
+    /**
+     * Writes the file header, the trees are appended with write
+     */
+    static void writeHeader(std::ostream& out);
+    static void write(std::ostream& out, const SuffixTree& tree);
+};
+
+#endif
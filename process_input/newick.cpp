@@ -3,29 +3,63 @@
 #include <vector>
 #include <fstream>
 #include <vector>
+#include <sstream>
 #include "newick.h"
 
 // TODO: read strings with gene id that maps to species + sequence, this way we can make a set! (unsorted_set?) of species based on the list of genes.
 
 void Newick::print_renormalised_tree(std::ostream& o, std::vector<std::string> species) {
-    // std::cerr << "printing renormalised tree with these species: " << std::endl;
-    root->resetUsed();
-    for (auto x : species) {
-        // std::cerr << "- " << x << std::endl;
-        root->useSpecies(x);
-        // std::cerr << "tree: \n" << *root << std::endl;
+    std::vector<bool> subset = get_species_subset(species);
+    auto cached = renormalised_trees.find(subset);
+    if(cached == renormalised_trees.end()) {
+        // std::cerr << "printing renormalised tree with these species: " << std::endl;
+        root->resetUsed();
+        for (auto x : species) {
+            // std::cerr << "- " << x << std::endl;
+            if(species_bit.find(x) != species_bit.end()) root->useSpecies(x); // unknown species are reported in get_species_subset
+            // std::cerr << "tree: \n" << *root << std::endl;
+        }
+        root->getMinimimTree();
+        float subtree_sum = root->get_length_sum();
+        // std::cerr << "sum : " << subtree_sum << std::endl;
+        // std::cerr << "final tree: ";
+        // root->print_renormalised(std::cerr, subtree_sum);
+        // std::cerr << std::endl;
+        std::ostringstream tree;
+        tree.flags(o.flags());
+        tree.precision(o.precision());
+        root->print_newick_renormalised(tree, subtree_sum);
+        cached = renormalised_trees.emplace(subset, tree.str()).first;
     }
-    root->getMinimimTree();
-    float subtree_sum = root->get_length_sum();
-    // std::cerr << "sum : " << subtree_sum << std::endl;
-    // std::cerr << "final tree: ";
-    // root->print_renormalised(std::cerr, subtree_sum);
-    // std::cerr << std::endl;
     // o << "final newick: ";
-    root->print_newick_renormalised(o, subtree_sum);
-    o << '\n';
+    o << cached->second << '\n';
     // loop over tree and connect species with minimum tree and get sum.
 }
+std::vector<bool> Newick::get_species_subset(const std::vector<std::string> &species) {
+    std::vector<bool> subset(species_bit.size(), false);
+    for (auto x : species) {
+        auto bit = species_bit.find(x);
+        if(bit == species_bit.end()) {
+            std::cerr << "species " << x  << " not found, skipping " << std::endl;
+        } else {
+            subset[bit->second] = true;
+        }
+    }
+    return subset;
+}
+void Newick::index_species() {
+    // same depth first order as newick_node::recFindSpecies so the first node with a given name gets the bit
+    std::stack<newick_node *> stack;
+    stack.push(root);
+
+    while (!stack.empty()) {
+            newick_node* node = stack.top();
+            stack.pop();
+            if(!node->getName().empty()) species_bit.emplace(node->getName(), species_bit.size());
+            if(node->getNext() != NULL) stack.push(node->getNext());
+            if(node->getChild() != NULL) stack.push(node->getChild());
+    }
+}
 void Newick::remove_newick_nodes() {
     // Depth-first traversal of the tree
     std::stack<newick_node *> stack;
@@ -122,6 +156,7 @@ void Newick::prep_newick(std::string newickfile) {
         }
         f.close();
     }
+    if(root != NULL) index_species();
     // std::cerr << "tree: \n" << *root << std::endl;
     // std::vector<std::string> keys = {
     //     "zma", "zma-ph207", "bdi", "cam",
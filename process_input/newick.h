@@ -110,6 +110,7 @@ public:
     newick_node *setChild(newick_node *child_) { child = child_; return child; }
     newick_node *getChild() const { return child; }
     newick_node *getNext() const { return next; }
+    const std::string& getName() const { return name; }
     bool useSpecies(std::string x) {
         // find the species, depth first.
         newick_node *found_node = recFindSpecies(x);
@@ -192,10 +193,16 @@ private:
   std::unordered_map<std::string, int> lengths;
   char delim = '\t';
   newick_node* root = NULL;
+  // every named node gets a bit in the species subset, the finished renormalised newick string is cached per subset
+  // since the number of distinct subsets is small compared to the number of clusters
+  std::unordered_map<std::string, size_t> species_bit;
+  std::unordered_map<std::vector<bool>, std::string> renormalised_trees;
 
   newick_node *build_newick_recursive(std::string &newick_string, int level);
   newick_node *get_first_child(std::string &newick_string, int level);
   void prep_newick(std::string newickfile);
+  void index_species();
+  std::vector<bool> get_species_subset(const std::vector<std::string> &species);
   void remove_newick_nodes();
 public:
     Newick(std::string newickfile) : sum(0){